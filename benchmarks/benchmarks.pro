@@ -0,0 +1,28 @@
+## Standalone build of the project loading benchmarks, see cmakebenchmarks.h. Needs the same
+## QTC_SOURCE/QTC_BUILD setup (and LIBS) as the plugin itself, but no running Qt Creator.
+
+## set the QTC_SOURCE environment variable to override the setting here
+QTCREATOR_SOURCES = $$(QTC_SOURCE)
+
+## set the QTC_BUILD environment variable to override the setting here
+IDE_BUILD_TREE = $$(QTC_BUILD_INPLACE)
+
+TARGET = cmakebenchmarks
+
+include(../cmakeprojectmanager_dependencies.pri)
+include($$QTCREATOR_SOURCES/tests/auto/qttest.pri)
+
+QT += widgets
+
+# The plugin sources are compiled in, without the plugin class and the plugin test slots:
+DEFINES += CMAKEPROJECTMANAGER_LIBRARY CMAKE_STANDALONE_BENCHMARKS
+DEFINES -= WITH_TESTS
+
+PLUGIN_DIR = $$PWD/..
+INCLUDEPATH += $$PLUGIN_DIR $$QTCREATOR_SOURCES/src/plugins/texteditor
+
+HEADERS += $$files($$PLUGIN_DIR/*.h)
+HEADERS -= $$PLUGIN_DIR/cmakeprojectplugin.h
+SOURCES += $$files($$PLUGIN_DIR/*.cpp)
+SOURCES -= $$PLUGIN_DIR/cmakeprojectplugin.cpp
+RESOURCES += $$PLUGIN_DIR/cmakeproject.qrc
@@ -30,12 +30,14 @@
 #include "cmakeprojectmanager.h"
 #include "cmakeprojectnodes.h"
 #include "cmaketool.h"
+#include "cmaketrace.h"
 
 #include <coreplugin/icore.h>
 #include <coreplugin/documentmanager.h>
 #include <coreplugin/messagemanager.h>
 #include <coreplugin/editormanager/editormanager.h>
 #include <coreplugin/progressmanager/progressmanager.h>
+#include <cpptools/projectinfo.h>
 #include <cpptools/projectpartbuilder.h>
 #include <projectexplorer/headerpath.h>
 #include <projectexplorer/kit.h>
@@ -46,22 +48,30 @@
 #include <projectexplorer/target.h>
 #include <projectexplorer/taskhub.h>
 #include <projectexplorer/toolchain.h>
+#include <qtsupport/baseqtversion.h>
+#include <qtsupport/qtkitinformation.h>
 
 #include <utils/algorithm.h>
 #include <utils/fileutils.h>
 #include <utils/qtcassert.h>
 #include <utils/qtcprocess.h>
-#include <utils/synchronousprocess.h>
+#include <utils/runextensions.h>
 
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QSet>
 #include <QTemporaryDir>
+#include <QVector>
 
-#include <chrono>
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+#endif
 
 using namespace ProjectExplorer;
 
@@ -72,6 +82,13 @@ using namespace ProjectExplorer;
 namespace CMakeProjectManager {
 namespace Internal {
 
+// Inactive build configurations refresh their data only after this quiet period:
+const int BACKGROUND_REFRESH_DELAY = 10000;
+// cmake output is collected this long before it is written to the message pane:
+const int MESSAGE_BATCH_INTERVAL = 100;
+// Issues found by the cmake output parser are handed to the issues pane in batches:
+const int TASK_BATCH_INTERVAL = 250;
+
 static QStringList toArguments(const CMakeConfig &config, const Kit *k) {
     return Utils::transform(config, [k](const CMakeConfigItem &i) -> QString {
         return i.toArgument(k->macroExpander());
@@ -87,25 +104,237 @@ bool sortNodesByPath(Node *a, Node *b)
     return a->filePath() < b->filePath();
 }
 
-QList<FileNode*> composeProjectTree(QList<FileNode*> cmakefiles,
-                                    QList<FileNode*> treefiles)
+// Merges the sorted file lists reported by cmake and found in the source tree. Both
+// lists are assumed to be sorted, entries from cmake win for files in both lists.
+QList<FileNodeInfo> composeProjectFiles(const QList<FileNodeInfo> &cmakeFiles,
+                                        const QList<FileNodeInfo> &treeFiles)
+{
+    QList<FileNodeInfo> result;
+    result.reserve(cmakeFiles.count() + treeFiles.count());
+
+    auto cit = cmakeFiles.constBegin();
+    auto tit = treeFiles.constBegin();
+    while (cit != cmakeFiles.constEnd() && tit != treeFiles.constEnd()) {
+        const int cmp = compareFilePaths(*cit, *tit);
+        if (cmp < 0) {
+            result.append(*cit++);
+        } else if (cmp > 0) {
+            result.append(*tit++);
+        } else {
+            result.append(*cit++);
+            ++tit;
+        }
+    }
+    for (; cit != cmakeFiles.constEnd(); ++cit)
+        result.append(*cit);
+    for (; tit != treeFiles.constEnd(); ++tit)
+        result.append(*tit);
+    return result;
+}
+
+FileNode *createFileNode(const FileNodeInfo &info)
+{
+    return new FileNode(info.filePath(), info.fileType, info.generated);
+}
+
+void collectFolders(FolderNode *folder, QHash<Utils::FileName, FolderNode *> &folders)
+{
+    folders.insert(folder->filePath(), folder);
+    foreach (FolderNode *subFolder, folder->subFolderNodes())
+        collectFolders(subFolder, folders);
+}
+
+// Closest folder of the tree that is (a parent of) directory, 0 if there is none.
+FolderNode *closestFolder(const QHash<Utils::FileName, FolderNode *> &folders,
+                          Utils::FileName directory)
+{
+    while (!directory.isEmpty()) {
+        FolderNode *folder = folders.value(directory);
+        if (folder)
+            return folder;
+        const Utils::FileName parent = directory.parentDir();
+        if (parent == directory)
+            break;
+        directory = parent;
+    }
+    return nullptr;
+}
+
+FolderNode *findOrCreateFolder(QHash<Utils::FileName, FolderNode *> &folders,
+                               const Utils::FileName &directory)
 {
-    // Assume: both input lists is sorted
+    FolderNode *folder = closestFolder(folders, directory);
+    QTC_ASSERT(folder, return nullptr);
+    if (folder->filePath() == directory)
+        return folder;
+
+    Utils::FileName path = folder->filePath();
+    const QString relative = directory.relativeChildPath(path).toString();
+    foreach (const QString &part, relative.split(QLatin1Char('/'), QString::SkipEmptyParts)) {
+        path.appendPath(part);
+        auto subFolder = new FolderNode(path, FolderNodeType, part);
+        folder->addFolderNodes({ subFolder });
+        folders.insert(path, subFolder);
+        folder = subFolder;
+    }
+    return folder;
+}
 
-    // Step 1: get only added files
-    QList<ProjectExplorer::FileNode *> added;
-    QList<ProjectExplorer::FileNode *> deleted;
-    ProjectExplorer::compareSortedLists(cmakefiles, treefiles, deleted, added, sortNodesByPath);
-    qDeleteAll(ProjectExplorer::subtractSortedList(treefiles, added, sortNodesByPath));
+// Brings the file nodes below root in line with files, touching only nodes that were
+// added, removed or changed their type. Returns false without changing anything if a
+// new file can not be placed into the existing folder structure.
+bool applyProjectFiles(FolderNode *root, const QList<FileNodeInfo> &files)
+{
+    QList<FileNode *> existing = root->recursiveFileNodes();
+    Utils::sort(existing, sortNodesByPath);
+
+    QList<FileNode *> removed;
+    QList<const FileNodeInfo *> added;
+    auto eit = existing.constBegin();
+    auto fit = files.constBegin();
+    while (eit != existing.constEnd() || fit != files.constEnd()) {
+        const int cmp = eit == existing.constEnd() ? -1
+                       : fit == files.constEnd() ? 1
+                       : compareFilePaths(*fit, (*eit)->filePath());
+        if (cmp > 0) {
+            removed.append(*eit++);
+        } else if (cmp < 0) {
+            added.append(&*fit++);
+        } else {
+            // Retag nodes whose type changed:
+            if ((*eit)->fileType() != fit->fileType || (*eit)->isGenerated() != fit->generated) {
+                removed.append(*eit);
+                added.append(&*fit);
+            }
+            ++eit;
+            ++fit;
+        }
+    }
+    if (removed.isEmpty() && added.isEmpty())
+        return true;
+
+    QHash<Utils::FileName, FolderNode *> folders;
+    collectFolders(root, folders);
+    foreach (const FileNodeInfo *info, added) {
+        if (!closestFolder(folders, Utils::FileName::fromString(info->directory)))
+            return false;
+    }
 
-    // Step 2: now add new files to the cmakefiles. Note: using cmakefiles as a base is a good idea!
-    //         also, keep result sorted
-    auto count = cmakefiles.count();
-    cmakefiles.append(added);
-    std::inplace_merge(cmakefiles.begin(), cmakefiles.begin() + count, cmakefiles.end(), sortNodesByPath);
+    // Remove in batches per folder and drop folders that became empty:
+    QHash<FolderNode *, QList<FileNode *>> removedByFolder;
+    foreach (FileNode *node, removed)
+        removedByFolder[node->parentFolderNode()].append(node);
+    for (auto it = removedByFolder.constBegin(); it != removedByFolder.constEnd(); ++it)
+        it.key()->removeFileNodes(it.value());
+    QSet<FolderNode *> removedFolders;
+    for (auto it = removedByFolder.constBegin(); it != removedByFolder.constEnd(); ++it) {
+        FolderNode *folder = it.key();
+        while (folder != root && !removedFolders.contains(folder)
+               && folder->fileNodes().isEmpty() && folder->subFolderNodes().isEmpty()) {
+            FolderNode *parent = folder->parentFolderNode();
+            removedFolders.insert(folder);
+            folders.remove(folder->filePath());
+            parent->removeFolderNodes({ folder });
+            folder = parent;
+        }
+    }
 
-    return cmakefiles;
+    // Add in batches per folder, files is sorted so siblings are next to each other:
+    FolderNode *folder = nullptr;
+    QList<FileNode *> nodes;
+    foreach (const FileNodeInfo *info, added) {
+        const Utils::FileName directory = Utils::FileName::fromString(info->directory);
+        if (!folder || folder->filePath() != directory) {
+            if (folder)
+                folder->addFileNodes(nodes);
+            nodes.clear();
+            folder = findOrCreateFolder(folders, directory);
+            QTC_ASSERT(folder, return false);
+        }
+        nodes.append(createFileNode(*info));
+    }
+    if (folder)
+        folder->addFileNodes(nodes);
+    return true;
 }
+// Calls of cmake commands, only as far as needed to find file globbing:
+struct CMakeCommand
+{
+    QString name; // lower case
+    QStringList arguments;
+};
+
+QList<CMakeCommand> parseCMakeCommands(const QString &contents)
+{
+    QList<CMakeCommand> result;
+    const int size = contents.size();
+    int pos = 0;
+    while (pos < size) {
+        const QChar c = contents.at(pos);
+        if (c == QLatin1Char('#')) {
+            pos = contents.indexOf(QLatin1Char('\n'), pos);
+            if (pos < 0)
+                break;
+            continue;
+        }
+        if (!c.isLetter() && c != QLatin1Char('_')) {
+            ++pos;
+            continue;
+        }
+
+        const int nameStart = pos;
+        while (pos < size && (contents.at(pos).isLetterOrNumber() || contents.at(pos) == QLatin1Char('_')))
+            ++pos;
+        CMakeCommand command;
+        command.name = contents.mid(nameStart, pos - nameStart).toLower();
+        while (pos < size && (contents.at(pos) == QLatin1Char(' ') || contents.at(pos) == QLatin1Char('\t')))
+            ++pos;
+        if (pos >= size || contents.at(pos) != QLatin1Char('('))
+            continue;
+        ++pos;
+
+        // Arguments up to the matching parenthesis:
+        int depth = 1;
+        QString argument;
+        bool quoted = false;
+        auto addArgument = [&command, &argument]() {
+            if (!argument.isEmpty())
+                command.arguments.append(argument);
+            argument.clear();
+        };
+        for (; pos < size && depth > 0; ++pos) {
+            const QChar a = contents.at(pos);
+            if (quoted) {
+                if (a == QLatin1Char('\\') && pos + 1 < size)
+                    argument.append(contents.at(++pos));
+                else if (a == QLatin1Char('"'))
+                    quoted = false;
+                else
+                    argument.append(a);
+            } else if (a == QLatin1Char('"')) {
+                quoted = true;
+            } else if (a == QLatin1Char('#')) {
+                addArgument();
+                while (pos + 1 < size && contents.at(pos + 1) != QLatin1Char('\n'))
+                    ++pos;
+            } else if (a == QLatin1Char('(')) {
+                ++depth;
+                argument.append(a);
+            } else if (a == QLatin1Char(')')) {
+                if (--depth > 0)
+                    argument.append(a);
+            } else if (a.isSpace()) {
+                addArgument();
+            } else {
+                argument.append(a);
+            }
+        }
+        addArgument();
+        result.append(command);
+    }
+    return result;
+}
+
 } // ::anonymous
 
 // --------------------------------------------------------------------
@@ -118,15 +347,33 @@ BuildDirManager::BuildDirManager(CMakeBuildConfiguration *bc) :
     QTC_ASSERT(bc, return);
     m_projectName = sourceDirectory().fileName();
 
-    m_reparseTimer.setSingleShot(true);
-
-    connect(&m_reparseTimer, &QTimer::timeout, this, &BuildDirManager::parse);
+    connect(&m_reparseScheduler, &ReparseScheduler::runRequested,
+            this, &BuildDirManager::runReparse);
+    connect(&m_checkInputsWatcher, &QFutureWatcherBase::finished,
+            this, &BuildDirManager::checkInputsFinished);
+    connect(&m_recordInputsWatcher, &QFutureWatcherBase::finished,
+            this, &BuildDirManager::recordInputsFinished);
+    connect(&m_codeModelDataWatcher, &QFutureWatcherBase::finished,
+            this, &BuildDirManager::codeModelDataFinished);
     connect(Core::EditorManager::instance(), &Core::EditorManager::aboutToSave,
             this, &BuildDirManager::handleDocumentSaves);
+
+    m_messageTimer.setSingleShot(true);
+    m_messageTimer.setInterval(MESSAGE_BATCH_INTERVAL);
+    connect(&m_messageTimer, &QTimer::timeout, this, &BuildDirManager::writeMessages);
+    m_taskTimer.setSingleShot(true);
+    m_taskTimer.setInterval(TASK_BATCH_INTERVAL);
+    connect(&m_taskTimer, &QTimer::timeout, this, &BuildDirManager::flushTasks);
 }
 
 BuildDirManager::~BuildDirManager()
 {
+    m_checkInputsWatcher.cancel();
+    m_checkInputsWatcher.waitForFinished();
+    m_recordInputsWatcher.cancel();
+    m_recordInputsWatcher.waitForFinished();
+    cancelCodeModelData();
+    m_codeModelDataWatcher.waitForFinished();
     stopProcess();
     resetData();
     delete m_tempDir;
@@ -174,6 +421,29 @@ bool BuildDirManager::isParsing() const
     return false;
 }
 
+bool BuildDirManager::hasData() const
+{
+    return m_hasData;
+}
+
+bool BuildDirManager::isActive() const
+{
+    return m_buildConfiguration->target()->project()->activeTarget() == m_buildConfiguration->target()
+            && m_buildConfiguration->target()->activeBuildConfiguration() == m_buildConfiguration;
+}
+
+void BuildDirManager::markStale()
+{
+    if (!m_hasData)
+        return;
+    m_dataStale = true;
+
+    // Keep retained data current in the background if cmake is supposed to run on its own:
+    const CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
+    if (tool && tool->isAutoRun())
+        m_reparseScheduler.schedule(ReparseScheduler::Parse, BACKGROUND_REFRESH_DELAY);
+}
+
 void BuildDirManager::cmakeFilesChanged()
 {
     if (isParsing())
@@ -183,7 +453,7 @@ void BuildDirManager::cmakeFilesChanged()
     if (!tool->isAutoRun())
         return;
 
-    m_reparseTimer.start(1000);
+    m_reparseScheduler.schedule(ReparseScheduler::Parse, 1000);
 }
 
 void BuildDirManager::forceReparse()
@@ -191,30 +461,72 @@ void BuildDirManager::forceReparse()
     if (m_buildConfiguration->target()->activeBuildConfiguration() != m_buildConfiguration)
         return;
 
+    // Several settings usually change in one go, so let those merge into one run:
+    m_reparseScheduler.schedule(ReparseScheduler::Configure, 0);
+}
+
+void BuildDirManager::runReparse(ReparseScheduler::RunKind kind)
+{
+    if (kind == ReparseScheduler::Parse) {
+        if (!isActive()) {
+            // A background refresh: give way to the active configuration and skip evicted data.
+            if (!m_hasData)
+                return;
+            auto activeBc = qobject_cast<CMakeBuildConfiguration *>(
+                        m_buildConfiguration->target()->activeBuildConfiguration());
+            if (activeBc && activeBc->isParsing()) {
+                m_reparseScheduler.schedule(ReparseScheduler::Parse, BACKGROUND_REFRESH_DELAY);
+                return;
+            }
+        }
+        parse(!isActive());
+        return;
+    }
+
+    if (m_buildConfiguration->target()->activeBuildConfiguration() != m_buildConfiguration)
+        return;
+
+    configure();
+}
+
+bool BuildDirManager::configure()
+{
     stopProcess();
+    m_backgroundRun = false;
 
     CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
-    QTC_ASSERT(tool, return);
+    QTC_ASSERT(tool && tool->isValid(), return false);
 
     startCMake(tool, CMakeGeneratorKitInformation::generatorArguments(kit()), intendedConfiguration(), cmakeToolchainInfo());
+    return isParsing();
 }
 
 void BuildDirManager::resetData()
 {
+    cancelCodeModelData();
     m_hasData = false;
+    m_dataStale = false;
+    m_hasCodeModelData = false;
 
     qDeleteAll(m_watchedFiles);
     m_watchedFiles.clear();
 
     m_cmakeCache.clear();
+    CMakeConfigItem::releaseUnusedInternedData();
     m_projectName.clear();
     m_buildTargets.clear();
     m_files.clear();
+    m_generatedFiles.clear();
+    m_compileCommands.clear();
+
+    m_globScopes.clear();
+    m_globScopesValid = false;
 }
 
 bool BuildDirManager::updateCMakeStateBeforeBuild()
 {
-    return m_reparseTimer.isActive();
+    // A running input check ends in dataAvailable() as well, with or without a cmake run:
+    return m_reparseScheduler.isPending() || m_checkInputsWatcher.isRunning();
 }
 
 bool BuildDirManager::persistCMakeState()
@@ -229,7 +541,9 @@ bool BuildDirManager::persistCMakeState()
     m_tempDir = nullptr;
 
     resetData();
-    QTimer::singleShot(0, this, &BuildDirManager::parse); // make sure signals only happen afterwards!
+    m_inputHashes.clear();
+    m_inputHashesLoaded = false;
+    m_reparseScheduler.schedule(ReparseScheduler::Parse, 0); // make sure signals only happen afterwards!
     return true;
 }
 
@@ -260,42 +574,98 @@ void BuildDirManager::generateProjectTree(CMakeProjectNode *root, const QList<Fi
         m_watchedFiles.insert(cm);
     }
 
-    // Compose lists
-    auto tm = std::chrono::system_clock::now();
-
-    // Create nodes
-    auto cmakeFileNodes = Utils::transform(m_files, [](const FileNodeInfo& node) {
-        return new FileNode(node.filePath, node.fileType, node.generated);
-    });
-
-    auto treeFileNodes = Utils::transform(treeFiles, [](const FileNodeInfo& node) {
-        return new FileNode(node.filePath, node.fileType, node.generated);
-    });
+    const QList<FileNodeInfo> files = updateProjectTree(root, m_files, treeFiles);
 
-    auto treeFilesCount = treeFiles.count();
-    auto cmakeFilesCount = m_files.count();
-    cmakeFileNodes = composeProjectTree(cmakeFileNodes, treeFileNodes);
-    qDebug() << "Extract data," << "Tree:" << treeFilesCount << "CMake:" << cmakeFilesCount << "Total:" << cmakeFileNodes.count();
-    auto delta = std::chrono::system_clock::now() - tm;
-    qDebug() << "Files composing time:" << std::chrono::duration_cast<std::chrono::milliseconds>(delta).count();
+    // Serve the file lists from the flat, sorted table instead of walking the node tree:
+    auto project = static_cast<CMakeProject*>(m_buildConfiguration->target()->project());
+    project->updateFilesCache(files);
+}
 
-    tm = std::chrono::system_clock::now();
+QList<FileNodeInfo> BuildDirManager::updateProjectTree(FolderNode *root,
+                                                       const QList<FileNodeInfo> &cmakeFiles,
+                                                       const QList<FileNodeInfo> &treeFiles)
+{
+    // Compose lists
+    QList<FileNodeInfo> files;
+    {
+        TraceSpan span(traceTree(), "Compose project files");
+        files = composeProjectFiles(cmakeFiles, treeFiles);
+    }
+    qCDebug(traceTree) << "Tree:" << treeFiles.count() << "CMake:" << cmakeFiles.count() << "Total:" << files.count();
 
-    auto project = static_cast<CMakeProject*>(m_buildConfiguration->target()->project());
-    project->updateFilesCache(cmakeFileNodes);
-    root->buildTree(cmakeFileNodes);
+    TraceSpan span(traceTree(), "Update project tree");
 
-    delta = std::chrono::system_clock::now() - tm;
-    qDebug() << "Tree generation time:" << std::chrono::duration_cast<std::chrono::milliseconds>(delta).count();
+    // Update the existing tree in place where possible, so that unchanged nodes (and the
+    // expansion state of the project view) survive:
+    if ((root->fileNodes().isEmpty() && root->subFolderNodes().isEmpty())
+            || !applyProjectFiles(root, files)) {
+        QList<FileNode *> nodes = Utils::transform(files, [](const FileNodeInfo &info) {
+            return createFileNode(info);
+        });
+        root->buildTree(nodes);
+    }
+    return files;
 }
 
-QSet<Core::Id> BuildDirManager::updateCodeModel(CppTools::ProjectPartBuilder &ppBuilder)
+QSet<Core::Id> BuildDirManager::updateCodeModel(CppTools::ProjectInfo &pinfo,
+                                                CppTools::ProjectPartBuilder &ppBuilder,
+                                                bool *changed)
 {
+    TraceSpan span(traceCodeModel(), "Update code model");
+
     QSet<Core::Id> languages;
     ToolChain *tcCxx = ToolChainKitInformation::toolChain(kit(), ToolChain::Language::Cxx);
     ToolChain *tcC = ToolChainKitInformation::toolChain(kit(), ToolChain::Language::C);
     const Utils::FileName sysroot = SysRootKitInformation::sysRoot(kit());
+    const QtSupport::BaseQtVersion *qtVersion = QtSupport::QtKitInformation::qtVersion(kit());
+
+    // Everything besides the parts themselves that goes into the project parts:
+    const QString kitKey = QString::fromLatin1(tcCxx ? tcCxx->id() : QByteArray()) + QLatin1Char('\0')
+            + QString::fromLatin1(tcC ? tcC->id() : QByteArray()) + QLatin1Char('\0')
+            + sysroot.toString() + QLatin1Char('\0')
+            + (qtVersion ? qtVersion->qtVersionString() : QString());
+
+    // Asking the compiler for its include paths is expensive, so remember them across updates:
+    auto toolchainIncludes = [this, &kitKey, sysroot](ToolChain *tc, const QStringList &flags) {
+        const QString key = kitKey + QLatin1Char('\0') + QString::fromLatin1(tc->id())
+                + QLatin1Char('\0') + flags.join('\n');
+        auto it = m_toolchainIncludes.constFind(key);
+        if (it == m_toolchainIncludes.constEnd()) {
+            QSet<Utils::FileName> includes;
+            foreach (const HeaderPath &hp, tc->systemHeaderPaths(flags, sysroot))
+                includes.insert(Utils::FileName::fromString(hp.path()));
+            it = m_toolchainIncludes.insert(key, includes);
+        }
+        return it.value();
+    };
 
+    // Files with equal flags share one project part, even across targets:
+    struct CodeModelPart
+    {
+        QString key;
+        QString displayName;
+        QStringList includePaths;
+        QByteArray defines;
+        QStringList cFlags;
+        QStringList cxxFlags;
+        QStringList files;
+    };
+    QVector<CodeModelPart> parts;
+    QHash<QString, int> partIndex;
+    auto addFile = [&parts, &partIndex](const QString &displayName, const QStringList &includePaths,
+                                        const QByteArray &defines, const QStringList &cFlags,
+                                        const QStringList &cxxFlags, const QString &file) {
+        const QString key = includePaths.join('\n') + QLatin1Char('\0') + QString::fromUtf8(defines)
+                + QLatin1Char('\0') + cFlags.join('\n') + QLatin1Char('\0') + cxxFlags.join('\n');
+        auto it = partIndex.constFind(key);
+        if (it == partIndex.constEnd()) {
+            it = partIndex.insert(key, parts.size());
+            parts.append({ key, displayName, includePaths, defines, cFlags, cxxFlags, QStringList() });
+        }
+        parts[it.value()].files.append(file);
+    };
+
+    const QString buildDir = buildDirectory().toString();
     QHash<QString, QStringList> targetDataCacheCxx;
     QHash<QString, QStringList> targetDataCacheC;
     foreach (const CMakeBuildTarget &cbt, buildTargets()) {
@@ -309,35 +679,96 @@ QSet<Core::Id> BuildDirManager::updateCodeModel(CppTools::ProjectPartBuilder &pp
         auto cflags = getFlagsFor(cbt, targetDataCacheC, ToolChain::Language::C);
         QSet<Utils::FileName> tcIncludes;
         if (tcCxx)
-            foreach (const HeaderPath &hp, tcCxx->systemHeaderPaths(cxxflags, sysroot))
-                tcIncludes.insert(Utils::FileName::fromString(hp.path()));
+            tcIncludes.unite(toolchainIncludes(tcCxx, cxxflags));
         if (tcC)
-            foreach (const HeaderPath &hp, tcC->systemHeaderPaths(cflags, sysroot))
-                tcIncludes.insert(Utils::FileName::fromString(hp.path()));
+            tcIncludes.unite(toolchainIncludes(tcC, cflags));
         QStringList includePaths;
         foreach (const Utils::FileName &i, cbt.includeFiles) {
             if (!tcIncludes.contains(i))
                 includePaths.append(i.toString());
         }
-        includePaths += buildDirectory().toString();
-        ppBuilder.setIncludePaths(includePaths);
-        ppBuilder.setCFlags(cflags);
-        ppBuilder.setCxxFlags(cxxflags);
-        ppBuilder.setDefines(cbt.defines);
-        ppBuilder.setDisplayName(cbt.title);
-
-        const QSet<Core::Id> partLanguages
-                = QSet<Core::Id>::fromList(ppBuilder.createProjectPartsForFiles(
-                                               Utils::transform(cbt.files, [](const Utils::FileName &fn) { return fn.toString(); })));
-
-        languages.unite(partLanguages);
+        includePaths += buildDir;
+
+        // Sources compiled with their own flags (e.g. from set_source_files_properties())
+        // get them from the compilation database, anything else uses the target flags.
+        // Equal flag sets are stored once, so comparing the pointers is enough:
+        foreach (const Utils::FileName &file, cbt.files) {
+            const bool c = CompileCommands::isCSource(file.toString());
+            const CompileCommands::Flags *flags = m_compileCommands.flagsFor(file);
+            if (!flags || flags == m_compileCommands.flagsForTarget(cbt.title, c)) {
+                addFile(cbt.title, includePaths, cbt.defines, cflags, cxxflags, file.toString());
+                continue;
+            }
+
+            QStringList sourceIncludePaths;
+            foreach (const QString &i, flags->includePaths) {
+                if (!tcIncludes.contains(Utils::FileName::fromString(i)))
+                    sourceIncludePaths.append(i);
+            }
+            sourceIncludePaths += buildDir;
+            addFile(cbt.title, sourceIncludePaths, flags->defines,
+                    c ? flags->flags : cflags, c ? cxxflags : flags->flags, file.toString());
+        }
     }
+
+    // Only parts that differ from the last update are created anew, so the indexer can
+    // skip the others:
+    QHash<QString, CodeModelParts> previousParts;
+    previousParts.swap(m_codeModelParts);
+    QSet<QString> changedTargets;
+    int createdParts = 0;
+    foreach (const CodeModelPart &part, parts) {
+        const QString fingerprint = kitKey + QLatin1Char('\0') + part.displayName + QLatin1Char('\0')
+                + part.key + QLatin1Char('\0') + part.files.join('\n');
+
+        CodeModelParts cached = previousParts.value(fingerprint);
+        if (cached.projectParts.isEmpty()) {
+            changedTargets.insert(part.displayName);
+            ++createdParts;
+
+            ppBuilder.setIncludePaths(part.includePaths);
+            ppBuilder.setCFlags(part.cFlags);
+            ppBuilder.setCxxFlags(part.cxxFlags);
+            ppBuilder.setDefines(part.defines);
+            ppBuilder.setDisplayName(part.displayName);
+
+            const int first = pinfo.projectParts().size();
+            cached.languages = ppBuilder.createProjectPartsForFiles(part.files);
+            cached.projectParts = pinfo.projectParts().mid(first);
+        } else {
+            foreach (const CppTools::ProjectPart::Ptr &projectPart, cached.projectParts)
+                pinfo.appendProjectPart(projectPart);
+        }
+
+        languages.unite(QSet<Core::Id>::fromList(cached.languages));
+        m_codeModelParts.insert(fingerprint, cached);
+    }
+
+    const bool partsChanged = !changedTargets.isEmpty() || previousParts.size() != m_codeModelParts.size();
+    qCDebug(traceCodeModel) << "Changed code model targets:" << changedTargets.toList()
+                            << "reused parts:" << (m_codeModelParts.size() - createdParts);
+    if (changed)
+        *changed = partsChanged;
     return languages;
 }
 
-void BuildDirManager::parse()
+void BuildDirManager::parse(bool background)
 {
-    checkConfiguration();
+    if (background) {
+        // Without the user looking at this configuration, a changed cache can not be
+        // resolved; leave that to maybeForceReparse() once it gets active again:
+        const CMakeConfig cache = parsedConfiguration();
+        CMakeConfig newConfig;
+        QSet<QString> changedKeys;
+        QSet<QString> removedKeys;
+        if (!m_tempDir && !cache.isEmpty()
+                && compareConfiguration(cache, &newConfig, &changedKeys, &removedKeys)) {
+            return;
+        }
+    } else {
+        checkConfiguration();
+    }
+    m_backgroundRun = background;
 
     CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
     const QStringList generatorArgs = CMakeGeneratorKitInformation::generatorArguments(kit());
@@ -352,19 +783,94 @@ void BuildDirManager::parse()
         return;
     }
 
-    const bool mustUpdate = m_cmakeFiles.isEmpty()
-            || Utils::anyOf(m_cmakeFiles, [&cbpFileFi](const Utils::FileName &f) {
-                   return f.toFileInfo().lastModified() > cbpFileFi.lastModified();
-               });
-    if (mustUpdate) {
+    if (m_cmakeFiles.isEmpty()) {
         startCMake(tool, generatorArgs, CMakeConfig(), CMakeToolchainInfo());
-    } else {
+        return;
+    }
+
+    const Utils::FileName cbpFileName = Utils::FileName::fromString(cbpFile);
+    const QList<Utils::FileName> touched = Utils::filtered(m_cmakeFiles.toList(),
+                                                        [&cbpFileFi, &cbpFileName](const Utils::FileName &f) {
+        return f != cbpFileName && f.toFileInfo().lastModified() > cbpFileFi.lastModified();
+    });
+    if (touched.isEmpty()) {
         completeParsing();
+        return;
     }
+
+    // Only rerun cmake if the content of one of the touched files really changed:
+    if (!m_inputHashesLoaded) {
+        m_inputHashes = CMakeInputLedger::load(CMakeInputLedger::ledgerFile(workDirectory()));
+        m_inputHashesLoaded = true;
+    }
+    if (m_inputHashes.isEmpty()) {
+        startCMake(tool, generatorArgs, CMakeConfig(), CMakeToolchainInfo());
+        return;
+    }
+    m_checkInputsWatcher.cancel();
+    m_checkInputsWatcher.setFuture(Utils::runAsync(&CMakeInputLedger::hashFiles, touched));
+}
+
+void BuildDirManager::checkInputsFinished()
+{
+    const QFuture<CMakeInputLedger::Hashes> future = m_checkInputsWatcher.future();
+    if (future.isCanceled() || future.resultCount() == 0 || isParsing())
+        return;
+
+    if (!CMakeInputLedger::hasChanges(m_inputHashes, future.result())) {
+        completeParsing();
+        return;
+    }
+
+    CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
+    QTC_ASSERT(tool, return);
+    startCMake(tool, CMakeGeneratorKitInformation::generatorArguments(kit()),
+               CMakeConfig(), CMakeToolchainInfo());
+}
+
+void BuildDirManager::recordInputs()
+{
+    const Utils::FileName cbpFile
+            = Utils::FileName::fromString(CMakeManager::findCbpFile(workDirectory().toString()));
+    QList<Utils::FileName> inputs = m_cmakeFiles.toList();
+    inputs.removeAll(cbpFile);
+
+    m_recordInputsWatcher.cancel();
+    m_recordInputsWatcher.setFuture(Utils::runAsync(&CMakeInputLedger::hashFiles, inputs));
+}
+
+void BuildDirManager::recordInputsFinished()
+{
+    const QFuture<CMakeInputLedger::Hashes> future = m_recordInputsWatcher.future();
+    if (future.isCanceled() || future.resultCount() == 0 || isParsing())
+        return;
+
+    // Files changed since cmake started were possibly not seen by it. Leave them out, so
+    // that the next parse() does not mistake their content for the one cmake used. Files
+    // in the build directory are written by cmake itself.
+    CMakeInputLedger::Hashes hashes = future.result();
+    const QString buildPrefix = workDirectory().toString() + QLatin1Char('/');
+    const qint64 startSecs = m_cmakeStartTime.toMSecsSinceEpoch() / 1000; // mtimes may lack ms
+    for (auto it = hashes.begin(); it != hashes.end(); ) {
+        const QString path = it.key().toString();
+        if (!path.startsWith(buildPrefix)
+                && it.key().toFileInfo().lastModified().toMSecsSinceEpoch() / 1000 >= startSecs) {
+            it = hashes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_inputHashes = hashes;
+    m_inputHashesLoaded = true;
+    CMakeInputLedger::save(CMakeInputLedger::ledgerFile(workDirectory()), m_inputHashes);
 }
 
 void BuildDirManager::clearCache()
 {
+    m_inputHashes.clear();
+    m_inputHashesLoaded = false;
+
     auto cmakeCache = Utils::FileName(workDirectory()).appendPath(QLatin1String("CMakeCache.txt"));
     auto cmakeFiles = Utils::FileName(workDirectory()).appendPath(QLatin1String("CMakeFiles"));
 
@@ -383,6 +889,11 @@ QList<CMakeBuildTarget> BuildDirManager::buildTargets() const
     return m_buildTargets;
 }
 
+const GeneratedFilesIndex &BuildDirManager::generatedFiles() const
+{
+    return m_generatedFiles;
+}
+
 CMakeConfig BuildDirManager::parsedConfiguration() const
 {
     if (m_cmakeCache.isEmpty()) {
@@ -419,7 +930,17 @@ void BuildDirManager::stopProcess()
             m_cmakeProcess->kill();
     }
 
+    m_stdOutLines.clear();
+    m_stdErrLines.clear();
+    writeMessages();
     cleanUpProcess();
+    m_backgroundRun = false;
+    m_reparseScheduler.runFinished(true);
+    emit cmakeRunFinished();
+    if (m_cmakeRunStart >= 0) {
+        Trace::record(traceCMake(), "Run cmake (cancelled)", m_cmakeRunStart, Trace::now());
+        m_cmakeRunStart = -1;
+    }
 
     if (!m_future)
       return;
@@ -451,6 +972,14 @@ void BuildDirManager::cleanUpProcess()
     m_parser->flush();
     delete m_parser;
     m_parser = nullptr;
+
+    flushTasks();
+    if (m_duplicateTasks > 0 && !m_backgroundRun) {
+        Core::MessageManager::write(tr("%n duplicate issue(s) reported by cmake were suppressed.",
+                                       nullptr, m_duplicateTasks));
+    }
+    m_taskKeys.clear();
+    m_duplicateTasks = 0;
 }
 
 void BuildDirManager::extractData()
@@ -491,8 +1020,11 @@ void BuildDirManager::extractData()
     CMakeCbpParser cbpparser;
     CMakeTool *cmake = CMakeKitInformation::cmakeTool(kit());
     // Parsing
-    if (!cbpparser.parseCbpFile(cmake->pathMapper(), cbpFile, sourceDirectory()))
-        return;
+    {
+        TraceSpan span(traceCbp(), "Parse CodeBlocks project");
+        if (!cbpparser.parseCbpFile(cmake->pathMapper(), cbpFile, sourceDirectory()))
+            return;
+    }
 
     m_projectName = cbpparser.projectName();
 
@@ -511,6 +1043,70 @@ void BuildDirManager::extractData()
     m_buildTargets = cbpparser.buildTargets();
 }
 
+bool BuildDirManager::hasCodeModelData() const
+{
+    return m_hasCodeModelData;
+}
+
+void BuildDirManager::cancelCodeModelData()
+{
+    if (m_codeModelDataWatcher.isRunning())
+        m_codeModelDataWatcher.cancel();
+    m_codeModelDataStart = -1;
+}
+
+void BuildDirManager::loadCodeModelData(QFutureInterface<CodeModelData> &fi,
+                                        const Utils::FileName &workDirectory,
+                                        const QList<CMakeBuildTarget> &targets,
+                                        const QList<FileNodeInfo> &files)
+{
+    CodeModelData data;
+    fi.setProgressRange(0, 2);
+
+    data.generatedFiles = GeneratedFilesIndex::create(workDirectory, targets, files);
+    if (fi.isCanceled())
+        return;
+    fi.setProgressValue(1);
+
+    data.compileCommands.load(CompileCommands::databaseFile(workDirectory));
+    if (fi.isCanceled())
+        return;
+    fi.setProgressValue(2);
+
+    fi.reportResult(data);
+}
+
+void BuildDirManager::startCodeModelData()
+{
+    cancelCodeModelData();
+    m_hasCodeModelData = false;
+
+    m_codeModelDataStart = Trace::isEnabled(traceFlags()) ? Trace::now() : -1;
+    const QFuture<CodeModelData> future
+            = Utils::runAsync(&BuildDirManager::loadCodeModelData, workDirectory(), m_buildTargets, m_files);
+    m_codeModelDataWatcher.setFuture(future);
+    Core::ProgressManager::addTask(QFuture<void>(future),
+                                   tr("Reading code model data of \"%1\"").arg(m_projectName),
+                                   "CMake.CodeModelData");
+}
+
+void BuildDirManager::codeModelDataFinished()
+{
+    const QFuture<CodeModelData> future = m_codeModelDataWatcher.future();
+    if (future.isCanceled() || future.resultCount() == 0)
+        return;
+
+    const CodeModelData data = future.result();
+    m_generatedFiles = data.generatedFiles;
+    m_compileCommands = data.compileCommands;
+    m_hasCodeModelData = true;
+    if (m_codeModelDataStart >= 0) {
+        Trace::record(traceFlags(), "Read code model data", m_codeModelDataStart, Trace::now());
+        m_codeModelDataStart = -1;
+    }
+    emit codeModelDataAvailable();
+}
+
 void BuildDirManager::startCMake(CMakeTool *tool, const QStringList &generatorArgs,
                                  const CMakeConfig &config, const CMakeToolchainInfo &toolchain)
 {
@@ -520,6 +1116,10 @@ void BuildDirManager::startCMake(CMakeTool *tool, const QStringList &generatorAr
     QTC_ASSERT(!m_parser, return);
     QTC_ASSERT(!m_future, return);
 
+    m_stdOutLines.clear();
+    m_stdErrLines.clear();
+    writeMessages();
+
     // Find a directory to set up into:
     if (!buildDirectory().exists()) {
         if (!m_tempDir)
@@ -532,14 +1132,17 @@ void BuildDirManager::startCMake(CMakeTool *tool, const QStringList &generatorAr
 
     m_parser = new CMakeParser;
     QDir source = QDir(sourceDirectory().toString());
+    m_pendingTasks.clear();
+    m_taskKeys.clear();
+    m_duplicateTasks = 0;
     connect(m_parser, &IOutputParser::addTask, m_parser,
-            [source](const Task &task) {
+            [this, source](const Task &task) {
                 if (task.file.isEmpty() || task.file.toFileInfo().isAbsolute()) {
-                    TaskHub::addTask(task);
+                    queueTask(task);
                 } else {
                     Task t = task;
                     t.file = Utils::FileName::fromString(source.absoluteFilePath(task.file.toString()));
-                    TaskHub::addTask(t);
+                    queueTask(t);
                 }
             });
 
@@ -562,23 +1165,43 @@ void BuildDirManager::startCMake(CMakeTool *tool, const QStringList &generatorAr
     Utils::QtcProcess::addArg(&args, srcDir);
     Utils::QtcProcess::addArgs(&args, generatorArgs);
     Utils::QtcProcess::addArgs(&args, toArguments(config, kit()));
+    // Feeds the code model, unless the user configured it explicitly. Without a configuration
+    // cmake runs on the existing cache, which keeps the setting anyway:
+    if (!config.isEmpty() && !Utils::contains(config, [](const CMakeConfigItem &item) {
+                                                  return item.key == "CMAKE_EXPORT_COMPILE_COMMANDS";
+                                              })) {
+        Utils::QtcProcess::addArg(&args, QLatin1String("-DCMAKE_EXPORT_COMPILE_COMMANDS=ON"));
+    }
     Utils::QtcProcess::addArgs(&args, toolchain.arguments(toArguments(config, kit()), workDirectory().toString()));
 
-    TaskHub::clearTasks(ProjectExplorer::Constants::TASK_CATEGORY_BUILDSYSTEM);
+    // Issues and messages are shared by all configurations, so a background refresh
+    // must not replace those of the active one:
+    if (!m_backgroundRun) {
+        TaskHub::clearTasks(ProjectExplorer::Constants::TASK_CATEGORY_BUILDSYSTEM);
 
-    Core::MessageManager::write(tr("Running \"%1 %2\" in %3.")
-                                .arg(tool->cmakeExecutable().toUserOutput())
-                                .arg(args)
-                                .arg(workDirectory().toUserOutput()));
+        Core::MessageManager::write(tr("Running \"%1 %2\" in %3.")
+                                    .arg(tool->cmakeExecutable().toUserOutput())
+                                    .arg(args)
+                                    .arg(workDirectory().toUserOutput()));
+    }
 
     m_future = new QFutureInterface<void>();
     m_future->setProgressRange(0, 1);
-    Core::ProgressManager::addTask(m_future->future(),
-                                   tr("Configuring \"%1\"").arg(m_buildConfiguration->target()->project()->displayName()),
-                                   "CMake.Configure");
+    // Tell configurations apart when several of them run at once:
+    const QString projectName = m_buildConfiguration->target()->project()->displayName();
+    const QString title = isActive()
+            ? tr("Configuring \"%1\"").arg(projectName)
+            : tr("Configuring \"%1\" (%2, %3)").arg(projectName, kit()->displayName(),
+                                                     m_buildConfiguration->displayName());
+    Core::ProgressManager::addTask(m_future->future(), title, "CMake.Configure");
 
     m_cmakeProcess->setCommand(tool->cmakeExecutable().toString(), args);
+    m_checkInputsWatcher.cancel();
+    cancelCodeModelData(); // this run will bring new data
+    m_cmakeRunStart = Trace::isEnabled(traceCMake()) ? Trace::now() : -1;
+    m_cmakeStartTime = QDateTime::currentDateTime();
     m_cmakeProcess->start();
+    m_reparseScheduler.runStarted();
     emit configurationStarted();
 }
 
@@ -589,8 +1212,14 @@ void BuildDirManager::cmakeFinished(int code, QProcess::ExitStatus status)
     // process rest of the output:
     processCMakeOutput();
     processCMakeError();
+    flushCMakeOutput();
 
     cleanUpProcess();
+    m_reparseScheduler.runFinished();
+    if (m_cmakeRunStart >= 0) {
+        Trace::record(traceCMake(), "Run cmake", m_cmakeRunStart, Trace::now());
+        m_cmakeRunStart = -1;
+    }
 
     QString msg;
     if (status != QProcess::NormalExit)
@@ -599,8 +1228,10 @@ void BuildDirManager::cmakeFinished(int code, QProcess::ExitStatus status)
         msg = tr("*** cmake process exited with exit code %1.").arg(code);
 
     if (!msg.isEmpty()) {
-        Core::MessageManager::write(msg);
-        TaskHub::addTask(Task::Error, msg, ProjectExplorer::Constants::TASK_CATEGORY_BUILDSYSTEM);
+        if (!m_backgroundRun) {
+            Core::MessageManager::write(msg);
+            TaskHub::addTask(Task::Error, msg, ProjectExplorer::Constants::TASK_CATEGORY_BUILDSYSTEM);
+        }
         m_future->reportCanceled();
     } else {
         m_future->setProgressValue(1);
@@ -611,41 +1242,135 @@ void BuildDirManager::cmakeFinished(int code, QProcess::ExitStatus status)
     m_future = nullptr;
 
     completeParsing();
+    if (msg.isEmpty())
+        recordInputs();
+    else if (m_backgroundRun)
+        m_dataStale = true; // rerun visibly once the configuration gets active
+    m_backgroundRun = false;
+    emit cmakeRunFinished();
+}
+
+static QString decodeLine(const char *data, int size)
+{
+    if (size > 0 && data[size - 1] == '\r')
+        --size;
+    return QString::fromLocal8Bit(data, size);
 }
 
-static QString lineSplit(const QString &rest, const QByteArray &array, std::function<void(const QString &)> f)
+QStringList BuildDirManager::LineSplitter::append(const QByteArray &data)
 {
-    QString tmp = rest + Utils::SynchronousProcess::normalizeNewlines(QString::fromLocal8Bit(array));
+    QStringList lines;
+    m_pending.append(data);
+
+    // Only complete lines are decoded, so multi-byte characters are never split:
     int start = 0;
-    int end = tmp.indexOf(QLatin1Char('\n'), start);
+    int end = m_pending.indexOf('\n', start);
     while (end >= 0) {
-        f(tmp.mid(start, end - start));
+        lines.append(decodeLine(m_pending.constData() + start, end - start));
         start = end + 1;
-        end = tmp.indexOf(QLatin1Char('\n'), start);
+        end = m_pending.indexOf('\n', start);
     }
-    return tmp.mid(start);
+    m_pending.remove(0, start);
+    return lines;
+}
+
+QString BuildDirManager::LineSplitter::takeRest()
+{
+    const QString rest = decodeLine(m_pending.constData(), m_pending.size());
+    m_pending.clear();
+    return rest;
 }
 
 void BuildDirManager::processCMakeOutput()
 {
-    static QString rest;
-    rest = lineSplit(rest, m_cmakeProcess->readAllStandardOutput(), [this](const QString &s) { Core::MessageManager::write(s); });
+    if (m_backgroundRun) {
+        m_stdOutLines.append(m_cmakeProcess->readAllStandardOutput());
+        return;
+    }
+    m_pendingMessages.append(m_stdOutLines.append(m_cmakeProcess->readAllStandardOutput()));
+    if (!m_pendingMessages.isEmpty() && !m_messageTimer.isActive())
+        m_messageTimer.start();
 }
 
 void BuildDirManager::processCMakeError()
 {
-    static QString rest;
-    rest = lineSplit(rest, m_cmakeProcess->readAllStandardError(), [this](const QString &s) {
-        m_parser->stdError(s);
-        Core::MessageManager::write(s);
-    });
+    const QStringList lines = m_stdErrLines.append(m_cmakeProcess->readAllStandardError());
+    if (m_backgroundRun)
+        return;
+    foreach (const QString &line, lines)
+        m_parser->stdError(line);
+    m_pendingMessages.append(lines);
+    if (!m_pendingMessages.isEmpty() && !m_messageTimer.isActive())
+        m_messageTimer.start();
+}
+
+void BuildDirManager::flushCMakeOutput()
+{
+    if (m_backgroundRun) {
+        m_stdOutLines.clear();
+        m_stdErrLines.clear();
+        return;
+    }
+
+    // Output without a final newline:
+    const QString outRest = m_stdOutLines.takeRest();
+    if (!outRest.isEmpty())
+        m_pendingMessages.append(outRest);
+    const QString errRest = m_stdErrLines.takeRest();
+    if (!errRest.isEmpty()) {
+        if (m_parser)
+            m_parser->stdError(errRest);
+        m_pendingMessages.append(errRest);
+    }
+    writeMessages();
+}
+
+void BuildDirManager::writeMessages()
+{
+    m_messageTimer.stop();
+    if (m_pendingMessages.isEmpty())
+        return;
+    Core::MessageManager::write(m_pendingMessages.join(QLatin1Char('\n')));
+    m_pendingMessages.clear();
+}
+
+void BuildDirManager::queueTask(const Task &task)
+{
+    if (m_backgroundRun)
+        return;
+
+    // Noisy projects repeat the same warning for every inclusion of a file:
+    const QString key = task.file.toString() + QLatin1Char('\0') + QString::number(task.line)
+            + QLatin1Char('\0') + task.description;
+    if (m_taskKeys.contains(key)) {
+        ++m_duplicateTasks;
+        return;
+    }
+    m_taskKeys.insert(key);
+
+    m_pendingTasks.append(task);
+    if (!m_taskTimer.isActive())
+        m_taskTimer.start();
+}
+
+void BuildDirManager::flushTasks()
+{
+    m_taskTimer.stop();
+    const QList<Task> tasks = m_pendingTasks;
+    m_pendingTasks.clear();
+    foreach (const Task &task, tasks)
+        TaskHub::addTask(task);
 }
 
 void BuildDirManager::completeParsing()
 {
+    // The project tree and targets are published first, the code model data follows
+    // once it was read in the background:
     extractData(); // try even if cmake failed...
     m_hasData = true;
+    m_dataStale = false;
     emit dataAvailable();
+    startCodeModelData();
 }
 
 QStringList BuildDirManager::getFlagsFor(const CMakeBuildTarget &buildTarget,
@@ -657,12 +1382,20 @@ QStringList BuildDirManager::getFlagsFor(const CMakeBuildTarget &buildTarget,
     if (it != cache.constEnd())
         return *it;
 
+    TraceSpan span(traceFlags(), "Extract compiler flags");
+
     if (extractFlagsFromMake(buildTarget, cache, lang))
         return cache.value(buildTarget.title);
 
-    if (extractFlagsFromNinja(buildTarget, cache, lang))
+    if (extractFlagsFromNinja(buildTargets().at(0).workingDirectory, cache, lang))
         return cache.value(buildTarget.title);
 
+    if (const CompileCommands::Flags *flags
+            = m_compileCommands.flagsForTarget(buildTarget.title, lang == ToolChain::Language::C)) {
+        cache.insert(buildTarget.title, flags->flags);
+        return flags->flags;
+    }
+
     cache.insert(buildTarget.title, QStringList());
     return QStringList();
 }
@@ -724,11 +1457,10 @@ bool BuildDirManager::extractFlagsFromMake(const CMakeBuildTarget &buildTarget,
     return false;
 }
 
-bool BuildDirManager::extractFlagsFromNinja(const CMakeBuildTarget &buildTarget,
+bool BuildDirManager::extractFlagsFromNinja(const Utils::FileName &buildNinjaDirectory,
                                             QHash<QString, QStringList> &cache,
                                             ToolChain::Language lang)
 {
-    Q_UNUSED(buildTarget)
     if (!cache.isEmpty()) // We fill the cache in one go!
         return false;
 
@@ -749,7 +1481,7 @@ bool BuildDirManager::extractFlagsFromNinja(const CMakeBuildTarget &buildTarget,
     // found
     // Get "all" target's working directory
     QByteArray ninjaFile;
-    QString buildNinjaFile = buildTargets().at(0).workingDirectory.toString();
+    QString buildNinjaFile = buildNinjaDirectory.toString();
     buildNinjaFile += "/build.ninja";
     QFile buildNinja(buildNinjaFile);
     if (buildNinja.exists()) {
@@ -786,12 +1518,30 @@ bool BuildDirManager::extractFlagsFromNinja(const CMakeBuildTarget &buildTarget,
     return !cache.isEmpty();
 }
 
+bool BuildDirManager::compareConfiguration(const CMakeConfig &cache, CMakeConfig *newConfig,
+                                           QSet<QString> *changedKeys, QSet<QString> *removedKeys) const
+{
+    const Kit *k = kit();
+    foreach (const CMakeConfigItem &iBc, intendedConfiguration()) {
+        const CMakeConfigItem &iCache
+                = Utils::findOrDefault(cache, [&iBc](const CMakeConfigItem &i) { return i.key == iBc.key; });
+        if (iCache.isNull()) {
+            removedKeys->insert(QString::fromUtf8(iBc.key));
+        } else if (QString::fromUtf8(iCache.value) != iBc.expandedValue(k)) {
+            changedKeys->insert(QString::fromUtf8(iBc.key));
+            newConfig->append(iCache);
+        } else {
+            newConfig->append(iBc);
+        }
+    }
+    return !changedKeys->isEmpty() || !removedKeys->isEmpty();
+}
+
 void BuildDirManager::checkConfiguration()
 {
     if (m_tempDir) // always throw away changes in the tmpdir!
         return;
 
-    Kit *k = m_buildConfiguration->target()->kit();
     const CMakeConfig cache = parsedConfiguration();
     if (cache.isEmpty())
         return; // No cache file yet.
@@ -799,20 +1549,7 @@ void BuildDirManager::checkConfiguration()
     CMakeConfig newConfig;
     QSet<QString> changedKeys;
     QSet<QString> removedKeys;
-    foreach (const CMakeConfigItem &iBc, intendedConfiguration()) {
-        const CMakeConfigItem &iCache
-                = Utils::findOrDefault(cache, [&iBc](const CMakeConfigItem &i) { return i.key == iBc.key; });
-        if (iCache.isNull()) {
-            removedKeys << QString::fromUtf8(iBc.key);
-        } else if (QString::fromUtf8(iCache.value) != iBc.expandedValue(k)) {
-            changedKeys << QString::fromUtf8(iBc.key);
-            newConfig.append(iCache);
-        } else {
-            newConfig.append(iBc);
-        }
-    }
-
-    if (!changedKeys.isEmpty() || !removedKeys.isEmpty()) {
+    if (compareConfiguration(cache, &newConfig, &changedKeys, &removedKeys)) {
         QSet<QString> total = removedKeys + changedKeys;
         QStringList keyList = total.toList();
         Utils::sort(keyList);
@@ -842,39 +1579,137 @@ void BuildDirManager::checkConfiguration()
     }
 }
 
-void BuildDirManager::handleDocumentSaves(Core::IDocument *document)
+ReparseScheduler::Counters BuildDirManager::reparseCounters() const
 {
-    Target *t = m_buildConfiguration->target()->project()->activeTarget();
-    BuildConfiguration *bc = t ? t->activeBuildConfiguration() : nullptr;
+    return m_reparseScheduler.counters();
+}
 
-    if (!m_cmakeFiles.contains(document->filePath()) ||
-        m_buildConfiguration->target() != t ||
-        m_buildConfiguration != bc)
-        return;
+bool BuildDirManager::isConfigureNeededFor(const QStringList &filePaths) const
+{
+    if (!m_hasData)
+        return true;
+
+    const QList<GlobScope> scopes = globScopes();
+    foreach (const QString &filePath, filePaths) {
+        const Utils::FileName fileName = Utils::FileName::fromString(filePath);
+        if (m_cmakeFiles.contains(fileName)
+                || fileName.fileName() == QLatin1String("CMakeLists.txt")
+                || fileName.endsWith(QLatin1String(".cmake"))) {
+            return true;
+        }
 
-    m_reparseTimer.start(100);
+        const Utils::FileName directory = fileName.parentDir();
+        const bool globbed = Utils::anyOf(scopes, [&directory](const GlobScope &scope) {
+            return directory == scope.directory
+                    || (scope.recursive && directory.isChildOf(scope.directory));
+        });
+        if (globbed)
+            return true;
+    }
+    return false;
 }
 
-static QByteArray trimCMakeCacheLine(const QByteArray &in) {
-    int start = 0;
-    while (start < in.count() && (in.at(start) == ' ' || in.at(start) == '\t'))
-        ++start;
+QList<BuildDirManager::GlobScope> BuildDirManager::globScopes() const
+{
+    if (m_globScopesValid)
+        return m_globScopes;
+
+    m_globScopes.clear();
+    m_globScopesValid = true;
+
+    const Utils::FileName sourceDir = sourceDirectory();
+    const QString topDir = sourceDir.toString();
+    QSet<Utils::FileName> inputs = m_cmakeFiles;
+    inputs.insert(Utils::FileName(sourceDir).appendPath(QLatin1String("CMakeLists.txt")));
 
-    return in.mid(start, in.count() - start - 1);
+    foreach (const Utils::FileName &input, inputs) {
+        // Only the project's own cmake files can glob for project sources:
+        if (!input.isChildOf(sourceDir))
+            continue;
+        if (input.fileName() != QLatin1String("CMakeLists.txt") && !input.endsWith(QLatin1String(".cmake")))
+            continue;
+        QFile file(input.toString());
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            continue;
+
+        m_globScopes.append(globScopesOf(QString::fromUtf8(file.readAll()),
+                                         input.parentDir().toString(), topDir));
+    }
+    return m_globScopes;
 }
 
-static QByteArrayList splitCMakeCacheLine(const QByteArray &line) {
-    const int colonPos = line.indexOf(':');
-    if (colonPos < 0)
-        return QByteArrayList();
+QList<BuildDirManager::GlobScope> BuildDirManager::globScopesOf(const QString &contents,
+                                                                const QString &listDir,
+                                                                const QString &topDir)
+{
+    QList<GlobScope> result;
+    auto addScope = [&result, &listDir, &topDir](QString pattern, bool recursive) {
+        pattern.replace(QLatin1String("${CMAKE_CURRENT_SOURCE_DIR}"), listDir);
+        pattern.replace(QLatin1String("${CMAKE_CURRENT_LIST_DIR}"), listDir);
+        pattern.replace(QLatin1String("${CMAKE_SOURCE_DIR}"), topDir);
+        pattern.replace(QLatin1String("${PROJECT_SOURCE_DIR}"), topDir);
+        pattern.replace(QLatin1String("${CMAKE_HOME_DIRECTORY}"), topDir);
+
+        // Literal part of the pattern, anything behind a wildcard or an unknown
+        // variable might be any sub directory:
+        int literalEnd = pattern.size();
+        static const char *const specials[] = { "${", "*", "?", "[" };
+        for (const char *special : specials) {
+            const int index = pattern.indexOf(QLatin1String(special));
+            if (index >= 0 && index < literalEnd)
+                literalEnd = index;
+        }
+        // A wildcard in a directory part ("src/*/*.cpp") matches files in sub directories:
+        if (pattern.midRef(literalEnd).contains(QLatin1Char('/'))
+                || pattern.midRef(literalEnd).startsWith(QLatin1String("${"))) {
+            recursive = true;
+        }
+        QString directory = pattern.left(literalEnd);
+        if (literalEnd < pattern.size())
+            directory.truncate(qMax(0, directory.lastIndexOf(QLatin1Char('/'))));
+        if (QDir::isRelativePath(directory))
+            directory = directory.isEmpty() ? listDir : listDir + QLatin1Char('/') + directory;
+
+        GlobScope scope;
+        scope.directory = Utils::FileName::fromString(QDir::cleanPath(directory));
+        scope.recursive = recursive;
+        result.append(scope);
+    };
 
-    const int equalPos = line.indexOf('=', colonPos + 1);
-    if (equalPos < colonPos)
-        return QByteArrayList();
+    foreach (const CMakeCommand &command, parseCMakeCommands(contents)) {
+        if (command.name == QLatin1String("aux_source_directory")) {
+            if (!command.arguments.isEmpty())
+                addScope(command.arguments.first(), false);
+        } else if (command.name == QLatin1String("file") && command.arguments.count() > 2
+                   && command.arguments.first().startsWith(QLatin1String("GLOB"))) {
+            const bool recursive = command.arguments.first() == QLatin1String("GLOB_RECURSE");
+            // Skip the variable name and the options:
+            for (int i = 2; i < command.arguments.count(); ++i) {
+                const QString &argument = command.arguments.at(i);
+                if (argument == QLatin1String("RELATIVE") || argument == QLatin1String("LIST_DIRECTORIES"))
+                    ++i;
+                else if (argument != QLatin1String("FOLLOW_SYMLINKS")
+                         && argument != QLatin1String("CONFIGURE_DEPENDS"))
+                    addScope(argument, recursive);
+            }
+        }
+    }
+    return result;
+}
+
+void BuildDirManager::handleDocumentSaves(Core::IDocument *document)
+{
+    Target *t = m_buildConfiguration->target()->project()->activeTarget();
+    BuildConfiguration *bc = t ? t->activeBuildConfiguration() : nullptr;
 
-    return QByteArrayList() << line.mid(0, colonPos)
-                            << line.mid(colonPos + 1, equalPos - colonPos - 1)
-                            << line.mid(equalPos + 1);
+    if (!m_cmakeFiles.contains(document->filePath()))
+        return;
+    if (m_buildConfiguration->target() != t || m_buildConfiguration != bc) {
+        markStale();
+        return;
+    }
+
+    m_reparseScheduler.schedule(ReparseScheduler::Parse, 100);
 }
 
 static CMakeConfigItem::Type fromByteArray(const QByteArray &type) {
@@ -902,36 +1737,54 @@ CMakeConfig BuildDirManager::parseConfiguration(const Utils::FileName &cacheFile
         return CMakeConfig();
     }
 
+    // Read the cache in one go and work on raw views into that buffer: only values are
+    // copied out, keys and documentation are interned by CMakeConfigItem.
+    const QByteArray content = cache.readAll();
+    const char *data = content.constData();
+    const int size = content.size();
+
     QSet<QByteArray> advancedSet;
-    QMap<QByteArray, QByteArray> valuesMap;
+    QHash<QByteArray, QByteArray> valuesMap;
     QByteArray documentation;
-    while (!cache.atEnd()) {
-        const QByteArray line = trimCMakeCacheLine(cache.readLine());
-
+    int lineStart = 0;
+    while (lineStart < size) {
+        int lineEnd = content.indexOf('\n', lineStart);
+        if (lineEnd < 0)
+            lineEnd = size;
+        int start = lineStart;
+        while (start < lineEnd && (data[start] == ' ' || data[start] == '\t'))
+            ++start;
+        lineStart = lineEnd + 1;
+
+        const QByteArray line = QByteArray::fromRawData(data + start, lineEnd - start);
         if (line.isEmpty() || line.startsWith('#'))
             continue;
 
         if (line.startsWith("//")) {
-            documentation = line.mid(2);
+            documentation = QByteArray::fromRawData(line.constData() + 2, line.size() - 2);
             continue;
         }
 
-        const QByteArrayList pieces = splitCMakeCacheLine(line);
-        if (pieces.isEmpty())
+        const int colonPos = line.indexOf(':');
+        if (colonPos < 0)
+            continue;
+        const int equalPos = line.indexOf('=', colonPos + 1);
+        if (equalPos < colonPos)
             continue;
 
-        QTC_ASSERT(pieces.count() == 3, continue);
-        const QByteArray key = pieces.at(0);
-        const QByteArray type = pieces.at(1);
-        const QByteArray value = pieces.at(2);
+        const QByteArray key = QByteArray::fromRawData(line.constData(), colonPos);
+        const QByteArray type = QByteArray::fromRawData(line.constData() + colonPos + 1,
+                                                        equalPos - colonPos - 1);
+        const QByteArray value = QByteArray::fromRawData(line.constData() + equalPos + 1,
+                                                         line.size() - equalPos - 1);
 
         if (key.endsWith("-ADVANCED") && value == "1") {
-            advancedSet.insert(key.left(key.count() - 9 /* "-ADVANCED" */));
+            advancedSet.insert(QByteArray::fromRawData(key.constData(), key.count() - 9 /* "-ADVANCED" */));
         } else if (key.endsWith("-STRINGS") && fromByteArray(type) == CMakeConfigItem::INTERNAL) {
-            valuesMap[key.left(key.count() - 8) /* "-STRINGS" */] = value;
+            valuesMap.insert(QByteArray::fromRawData(key.constData(), key.count() - 8 /* "-STRINGS" */), value);
         } else {
             CMakeConfigItem::Type t = fromByteArray(type);
-            result << CMakeConfigItem(key, t, documentation, value);
+            result << CMakeConfigItem(key, t, documentation, QByteArray(value.constData(), value.size()));
         }
     }
 
@@ -940,8 +1793,9 @@ CMakeConfig BuildDirManager::parseConfiguration(const Utils::FileName &cacheFile
         CMakeConfigItem &item = result[i];
         item.isAdvanced = advancedSet.contains(item.key);
 
-        if (valuesMap.contains(item.key)) {
-            item.values = CMakeConfigItem::cmakeSplitValue(QString::fromUtf8(valuesMap[item.key]));
+        auto valuesIt = valuesMap.constFind(item.key);
+        if (valuesIt != valuesMap.constEnd()) {
+            item.values = CMakeConfigItem::cmakeSplitValue(QString::fromUtf8(*valuesIt));
         } else if (item.key  == "CMAKE_BUILD_TYPE") {
             // WA for known options
             item.values << "" << "Debug" << "Release" << "MinSizeRel" << "RelWithDebInfo";
@@ -960,6 +1814,8 @@ void BuildDirManager::handleCmakeFileChange()
 
     if (m_buildConfiguration->target() == t && m_buildConfiguration == bc)
         cmakeFilesChanged();
+    else
+        markStale();
 }
 
 void BuildDirManager::maybeForceReparse()
@@ -978,6 +1834,10 @@ void BuildDirManager::maybeForceReparse()
         return;
     }
 
+    // Retained data of a formerly inactive configuration, whose inputs changed meanwhile:
+    if (m_dataStale)
+        m_reparseScheduler.schedule(ReparseScheduler::Parse, 0);
+
     const CMakeConfig currentConfig = parsedConfiguration();
 
     const CMakeTool *tool = CMakeKitInformation::cmakeTool(kit());
@@ -1027,5 +1887,52 @@ void BuildDirManager::maybeForceReparse()
         forceReparse();
 }
 
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testGlobScopes_data()
+{
+    QTest::addColumn<QString>("contents");
+    QTest::addColumn<QStringList>("scopes"); // recursive ones end in "/**"
+
+    QTest::newRow("plain") << "file(GLOB SRCS *.cpp)" << QStringList({ "/src/sub" });
+    QTest::newRow("sub directory")
+            << "file(GLOB SRCS lib/*.cpp lib/*.h)" << QStringList({ "/src/sub/lib", "/src/sub/lib" });
+    QTest::newRow("wildcard directory")
+            << "file(GLOB SRCS src/*/*.cpp)" << QStringList({ "/src/sub/src/**" });
+    QTest::newRow("recurse") << "FILE(GLOB_RECURSE SRCS src/*.cpp)" << QStringList({ "/src/sub/src/**" });
+    QTest::newRow("quoted and commented")
+            << "file(GLOB SRCS # the sources\n  \"my dir/*.cpp\" # more\n)"
+            << QStringList({ "/src/sub/my dir" });
+    QTest::newRow("commented out") << "# file(GLOB SRCS *.cpp)\nset(A b)" << QStringList();
+    QTest::newRow("nested parentheses")
+            << "if((A AND B))\n  file(GLOB SRCS ${CMAKE_CURRENT_SOURCE_DIR}/gen/*.h)\nendif()"
+            << QStringList({ "/src/sub/gen" });
+    QTest::newRow("options")
+            << "file(GLOB SRCS RELATIVE ${CMAKE_SOURCE_DIR} LIST_DIRECTORIES false CONFIGURE_DEPENDS a/*.c)"
+            << QStringList({ "/src/sub/a" });
+    QTest::newRow("top directory")
+            << "file(GLOB HDRS ${PROJECT_SOURCE_DIR}/include/*.h)" << QStringList({ "/src/include" });
+    QTest::newRow("unknown variable")
+            << "file(GLOB SRCS ${MY_DIR}/*.c)" << QStringList({ "/src/sub/**" });
+    QTest::newRow("aux_source_directory")
+            << "aux_source_directory(. SRCS)" << QStringList({ "/src/sub" });
+    QTest::newRow("no glob") << "file(READ version.txt VERSION)" << QStringList();
+}
+
+void CMakeProjectPlugin::testGlobScopes()
+{
+    QFETCH(QString, contents);
+    QFETCH(QStringList, scopes);
+
+    const QStringList actual = Utils::transform(
+                BuildDirManager::globScopesOf(contents, "/src/sub", "/src"),
+                [](const BuildDirManager::GlobScope &scope) {
+        return scope.directory.toString() + (scope.recursive ? "/**" : "");
+    });
+    QCOMPARE(actual, scopes);
+}
+
+#endif
+
 } // namespace Internal
 } // namespace CMakeProjectManager
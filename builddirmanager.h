@@ -28,8 +28,13 @@
 #include "cmakecbpparser.h"
 #include "cmakeconfigitem.h"
 #include "cmakefile.h"
+#include "cmakeinputledger.h"
+#include "compilecommands.h"
+#include "generatedfilesindex.h"
+#include "reparsescheduler.h"
 #include "treebuilder.h"
 
+#include <cpptools/projectpart.h>
 #include <projectexplorer/task.h>
 #include <projectexplorer/toolchain.h>
 
@@ -38,9 +43,12 @@
 #include <utils/fileutils.h>
 
 #include <QByteArray>
+#include <QDateTime>
 #include <QFutureInterface>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QSet>
+#include <QStringList>
 #include <QTimer>
 
 #include <memory>
@@ -49,10 +57,14 @@ QT_FORWARD_DECLARE_CLASS(QTemporaryDir);
 QT_FORWARD_DECLARE_CLASS(QFileSystemWatcher);
 
 namespace Core { class IDocument; }
-namespace CppTools { class ProjectPartBuilder; }
+namespace CppTools {
+class ProjectInfo;
+class ProjectPartBuilder;
+} // namespace CppTools
 
 namespace ProjectExplorer {
 class FileNode;
+class FolderNode;
 class IOutputParser;
 class Kit;
 class Task;
@@ -78,33 +90,58 @@ public:
     const CMakeToolchainInfo& cmakeToolchainInfo() const;
 
     bool isParsing() const;
+    bool hasData() const;
 
     void clearCache();
     void forceReparse();
+    bool configure(); // even if not active, see ConfigureScheduler
+    void stopProcess();
     void maybeForceReparse(); // Only reparse if the configuration has changed...
     void resetData();
+    // The code model data (generated files, compile commands) is read in the background
+    // after dataAvailable() and may be cancelled independently of the cmake run:
+    bool hasCodeModelData() const;
+    void cancelCodeModelData();
     bool updateCMakeStateBeforeBuild();
     bool persistCMakeState();
 
     void generateProjectTree(CMakeProjectNode *root, const QList<Internal::FileNodeInfo> &treeFiles);
-    QSet<Core::Id> updateCodeModel(CppTools::ProjectPartBuilder &ppBuilder);
+    // Parts with unchanged files and flags are reused from the previous update, *changed
+    // tells whether any part differs from it:
+    QSet<Core::Id> updateCodeModel(CppTools::ProjectInfo &pinfo, CppTools::ProjectPartBuilder &ppBuilder,
+                                   bool *changed = nullptr);
 
     QList<CMakeBuildTarget> buildTargets() const;
+    const GeneratedFilesIndex &generatedFiles() const;
     CMakeConfig parsedConfiguration() const;
 
     void checkConfiguration();
 
+    // True if adding, removing or renaming the files can change the cmake result, because
+    // they are cmake inputs or might be picked up by file(GLOB) or aux_source_directory():
+    bool isConfigureNeededFor(const QStringList &filePaths) const;
+
+    ReparseScheduler::Counters reparseCounters() const;
+
     void handleDocumentSaves(Core::IDocument *document);
     void handleCmakeFileChange();
 
 signals:
     void configurationStarted() const;
     void dataAvailable() const;
+    void codeModelDataAvailable() const;
+    void cmakeRunFinished() const; // also if it was stopped
     void errorOccured(const QString &err) const;
 
 protected:
     static CMakeConfig parseConfiguration(const Utils::FileName &cacheFile,
                                           QString *errorMessage);
+    // Creates or updates all folder and file nodes below root. It does not create them
+    // lazily, because the project view reads the node lists directly. Returns the merged,
+    // sorted file table that CMakeProject serves its file lists from:
+    static QList<Internal::FileNodeInfo> updateProjectTree(ProjectExplorer::FolderNode *root,
+                                                           const QList<Internal::FileNodeInfo> &cmakeFiles,
+                                                           const QList<Internal::FileNodeInfo> &treeFiles);
 
     const ProjectExplorer::Kit *kit() const;
     const Utils::FileName buildDirectory() const;
@@ -113,27 +150,56 @@ protected:
     const CMakeConfig intendedConfiguration() const;
 
 private:
-    void parse();
+    void parse(bool background = false);
+    // True if the cmake cache differs from the intended configuration:
+    bool compareConfiguration(const CMakeConfig &cache, CMakeConfig *newConfig,
+                              QSet<QString> *changedKeys, QSet<QString> *removedKeys) const;
+    void runReparse(ReparseScheduler::RunKind kind);
 
     void cmakeFilesChanged();
+    bool isActive() const;
+    void markStale();
 
-    void stopProcess();
     void cleanUpProcess();
     void extractData();
 
+    struct CodeModelData
+    {
+        GeneratedFilesIndex generatedFiles;
+        CompileCommands compileCommands;
+    };
+    static void loadCodeModelData(QFutureInterface<CodeModelData> &fi,
+                                  const Utils::FileName &workDirectory,
+                                  const QList<CMakeBuildTarget> &targets,
+                                  const QList<Internal::FileNodeInfo> &files);
+    void startCodeModelData();
+    void codeModelDataFinished();
+
     void startCMake(CMakeTool *tool, const QStringList &generatorArgs, const CMakeConfig &config, const CMakeToolchainInfo &toolchain);   
 
     void cmakeFinished(int code, QProcess::ExitStatus status);
     void processCMakeOutput();
     void processCMakeError();
+    void flushCMakeOutput();
+    void writeMessages();
+    void queueTask(const ProjectExplorer::Task &task);
+    void flushTasks();
 
     void completeParsing();
 
+    void checkInputsFinished();
+    void recordInputs();
+    void recordInputsFinished();
+
     QStringList getFlagsFor(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache, ProjectExplorer::ToolChain::Language lang);
-    bool extractFlagsFromMake(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache, ProjectExplorer::ToolChain::Language lang);
-    bool extractFlagsFromNinja(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache, ProjectExplorer::ToolChain::Language lang);
+    static bool extractFlagsFromMake(const CMakeBuildTarget &buildTarget, QHash<QString, QStringList> &cache, ProjectExplorer::ToolChain::Language lang);
+    static bool extractFlagsFromNinja(const Utils::FileName &buildNinjaDirectory, QHash<QString, QStringList> &cache, ProjectExplorer::ToolChain::Language lang);
 
     bool m_hasData = false;
+    bool m_dataStale = false; // inputs changed while the configuration was inactive
+    bool m_hasCodeModelData = false;
+    // A refresh of an inactive configuration: no dialogs, issues or messages
+    bool m_backgroundRun = false;
 
     CMakeBuildConfiguration *m_buildConfiguration = nullptr;
     Utils::QtcProcess *m_cmakeProcess = nullptr;
@@ -141,17 +207,79 @@ private:
     mutable CMakeConfig m_cmakeCache;
 
     QSet<Utils::FileName> m_cmakeFiles;
+
+    struct GlobScope
+    {
+        Utils::FileName directory;
+        bool recursive = false;
+    };
+    QList<GlobScope> globScopes() const;
+    // Scopes of the file(GLOB...) and aux_source_directory() calls in one cmake file:
+    static QList<GlobScope> globScopesOf(const QString &contents, const QString &listDir,
+                                         const QString &topDir);
+    mutable QList<GlobScope> m_globScopes;
+    mutable bool m_globScopesValid = false;
     QString m_projectName;
     QList<CMakeBuildTarget> m_buildTargets;
     QList<Internal::FileNodeInfo> m_files;
+    GeneratedFilesIndex m_generatedFiles;
+    CompileCommands m_compileCommands;
+
+    // Code model state of the last update, see updateCodeModel():
+    struct CodeModelParts
+    {
+        QVector<CppTools::ProjectPart::Ptr> projectParts;
+        QList<Core::Id> languages;
+    };
+    QHash<QString, CodeModelParts> m_codeModelParts;
+    QHash<QString, QSet<Utils::FileName>> m_toolchainIncludes;
+
+    // Splits raw process output into lines, keeping an incomplete last line for later:
+    class LineSplitter
+    {
+    public:
+        QStringList append(const QByteArray &data);
+        QString takeRest();
+        void clear() { m_pending.clear(); }
+
+    private:
+        QByteArray m_pending;
+    };
+    LineSplitter m_stdOutLines;
+    LineSplitter m_stdErrLines;
+
+    // cmake output for the message pane, written in batches:
+    QStringList m_pendingMessages;
+    QTimer m_messageTimer;
+
+    // Issues of the current cmake run, handed to the TaskHub in batches:
+    QList<ProjectExplorer::Task> m_pendingTasks;
+    QSet<QString> m_taskKeys;
+    int m_duplicateTasks = 0;
+    QTimer m_taskTimer;
 
     // For error reporting:
     ProjectExplorer::IOutputParser *m_parser = nullptr;
     QFutureInterface<void> *m_future = nullptr;
+    qint64 m_cmakeRunStart = -1;
 
-    QTimer m_reparseTimer;
+    ReparseScheduler m_reparseScheduler;
+
+    // Content hashes of m_cmakeFiles as seen by the last cmake run:
+    CMakeInputLedger::Hashes m_inputHashes;
+    bool m_inputHashesLoaded = false;
+    QDateTime m_cmakeStartTime; // inputs modified later are not recorded
+    QFutureWatcher<CMakeInputLedger::Hashes> m_checkInputsWatcher;
+    QFutureWatcher<CMakeInputLedger::Hashes> m_recordInputsWatcher;
+    QFutureWatcher<CodeModelData> m_codeModelDataWatcher;
+    qint64 m_codeModelDataStart = -1;
 
     QSet<Internal::CMakeFile *> m_watchedFiles;
+
+#ifdef WITH_TESTS
+    friend class CMakeProjectPlugin;
+#endif
+    friend class CMakeBenchmarks;
 };
 
 } // namespace Internal
@@ -0,0 +1,351 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "cmakebenchmarks.h"
+
+#if defined(WITH_TESTS) || defined(CMAKE_STANDALONE_BENCHMARKS)
+
+#include "builddirmanager.h"
+#include "cmakecbpparser.h"
+#include "treebuilder.h"
+
+#include <projectexplorer/projectnodes.h>
+
+#include <utils/algorithm.h>
+#include <utils/fileutils.h>
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+using namespace ProjectExplorer;
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+int scaleFromEnvironment(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qgetenv(name).toInt(&ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+class SyntheticProject
+{
+public:
+    SyntheticProject() :
+        fileCount(scaleFromEnvironment("QTC_CMAKE_BENCH_FILES", 20000)),
+        targetCount(scaleFromEnvironment("QTC_CMAKE_BENCH_TARGETS", 200)),
+        depth(scaleFromEnvironment("QTC_CMAKE_BENCH_DEPTH", 4))
+    {
+        QTC_ASSERT(m_dir.isValid(), return);
+        sourceDirectory = Utils::FileName::fromString(m_dir.path() + QLatin1String("/source"));
+        buildDirectory = Utils::FileName::fromString(m_dir.path() + QLatin1String("/build"));
+        cbpFile = Utils::FileName(buildDirectory).appendPath(QLatin1String("Synthetic.cbp"));
+        cacheFile = Utils::FileName(buildDirectory).appendPath(QLatin1String("CMakeCache.txt"));
+
+        writeSources();
+        writeCbpFile();
+        writeCache();
+        writeFlags();
+    }
+
+    const int fileCount;
+    const int targetCount;
+    const int depth;
+
+    Utils::FileName sourceDirectory;
+    Utils::FileName buildDirectory;
+    Utils::FileName cbpFile;
+    Utils::FileName cacheFile;
+
+    QList<FileNodeInfo> cmakeFiles; // sources as cmake reports them
+    QList<FileNodeInfo> treeFiles;  // sources and headers as found on disk
+
+private:
+    QString targetName(int target) const
+    {
+        return QString::fromLatin1("target_%1").arg(target);
+    }
+
+    QString sourceBase(int file) const
+    {
+        QString path = sourceDirectory.toString() + QLatin1Char('/') + targetName(file % targetCount);
+        for (int level = 0; level < (file / targetCount) % depth; ++level)
+            path += QString::fromLatin1("/dir_%1").arg(level);
+        return path + QString::fromLatin1("/file_%1").arg(file);
+    }
+
+    void writeFile(const QString &fileName, const QByteArray &contents)
+    {
+        QDir().mkpath(QFileInfo(fileName).path());
+        QFile file(fileName);
+        QTC_ASSERT(file.open(QIODevice::WriteOnly), return);
+        file.write(contents);
+    }
+
+    void writeSources()
+    {
+        for (int i = 0; i < fileCount; ++i) {
+            const QString base = sourceBase(i);
+            const Utils::FileName cpp = Utils::FileName::fromString(base + QLatin1String(".cpp"));
+            const Utils::FileName header = Utils::FileName::fromString(base + QLatin1String(".h"));
+            writeFile(cpp.toString(), "int f() { return 0; }\n");
+            writeFile(header.toString(), "int f();\n");
+            cmakeFiles.append(FileNodeInfo(cpp, SourceType, false));
+            treeFiles.append(TreeBuilder::fileNodeInfo(cpp));
+            treeFiles.append(TreeBuilder::fileNodeInfo(header));
+        }
+        Utils::sort(cmakeFiles);
+        Utils::sort(treeFiles);
+    }
+
+    void writeCbpFile()
+    {
+        const QByteArray build = buildDirectory.toString().toUtf8();
+        QByteArray cbp = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                         "<CodeBlocks_project_file>\n<FileVersion major=\"1\" minor=\"6\" />\n"
+                         "<Project>\n<Option title=\"Synthetic\" />\n<Option compiler=\"gcc\" />\n<Build>\n";
+        for (int t = 0; t < targetCount; ++t) {
+            const QByteArray name = targetName(t).toUtf8();
+            cbp += "<Target title=\"" + name + "\">\n"
+                   "<Option output=\"" + build + "/" + name + "\" prefix_auto=\"0\" extension_auto=\"0\" />\n"
+                   "<Option working_dir=\"" + build + "\" />\n<Option type=\"1\" />\n"
+                   "<Option compiler=\"gcc\" />\n<Compiler>\n"
+                   "<Add option=\"-DTARGET_" + QByteArray::number(t) + "\" />\n"
+                   "<Add option=\"-DQT_CORE_LIB\" />\n"
+                   "<Add directory=\"" + sourceDirectory.toString().toUtf8() + "/" + name + "\" />\n"
+                   "<Add directory=\"/usr/include/qt5\" />\n</Compiler>\n<MakeCommands>\n"
+                   "<Build command=\"/usr/bin/make -f &quot;" + build + "/Makefile&quot;  VERBOSE=1 " + name + "\" />\n"
+                   "<CompileFile command=\"/usr/bin/make -f &quot;" + build + "/Makefile&quot;  VERBOSE=1 &quot;$file&quot;\" />\n"
+                   "<Clean command=\"/usr/bin/make -f &quot;" + build + "/Makefile&quot;  VERBOSE=1 clean\" />\n"
+                   "<DistClean command=\"/usr/bin/make -f &quot;" + build + "/Makefile&quot;  VERBOSE=1 clean\" />\n"
+                   "</MakeCommands>\n</Target>\n";
+        }
+        cbp += "</Build>\n";
+        for (int i = 0; i < fileCount; ++i) {
+            cbp += "<Unit filename=\"" + sourceBase(i).toUtf8() + ".cpp\">\n"
+                   "<Option target=\"" + targetName(i % targetCount).toUtf8() + "\" />\n</Unit>\n";
+        }
+        for (int t = 0; t < targetCount; ++t) {
+            cbp += "<Unit filename=\"" + sourceDirectory.toString().toUtf8() + "/" + targetName(t).toUtf8()
+                    + "/CMakeLists.txt\">\n<Option virtualFolder=\"CMake Files\\\" />\n</Unit>\n";
+        }
+        cbp += "</Project>\n</CodeBlocks_project_file>\n";
+        writeFile(cbpFile.toString(), cbp);
+    }
+
+    void writeCache()
+    {
+        QByteArray cache = "# This is the CMakeCache file.\n\n";
+        const int entryCount = 1000 + 10 * targetCount;
+        for (int i = 0; i < entryCount; ++i) {
+            const QByteArray key = "SYNTHETIC_OPTION_" + QByteArray::number(i);
+            cache += "//Documentation of option " + QByteArray::number(i % 50) + "\n";
+            switch (i % 4) {
+            case 0:
+                cache += key + ":BOOL=ON\n" + key + "-ADVANCED:INTERNAL=1\n";
+                break;
+            case 1:
+                cache += key + ":STRING=Release\n" + key + "-STRINGS:INTERNAL=Debug;Release;MinSizeRel\n";
+                break;
+            case 2:
+                cache += key + ":PATH=" + sourceDirectory.toString().toUtf8() + "/some/path\n";
+                break;
+            default:
+                cache += key + ":INTERNAL=" + QByteArray::number(i) + "\n";
+                break;
+            }
+        }
+        cache += "CMAKE_HOME_DIRECTORY:INTERNAL=" + sourceDirectory.toString().toUtf8() + "\n";
+        writeFile(cacheFile.toString(), cache);
+    }
+
+    void writeFlags()
+    {
+        const QByteArray flags = "-O2 -g -fPIC -Wall -Wextra -std=gnu++11 -D'HAS_FEATURE()'=1 -DQT_CORE_LIB";
+        const QString build = buildDirectory.toString();
+        QByteArray ninja;
+        for (int t = 0; t < targetCount; ++t) {
+            const QString name = targetName(t);
+            writeFile(build + QLatin1String("/CMakeFiles/") + name + QLatin1String(".dir/flags.make"),
+                      "# CMAKE generated file: DO NOT EDIT!\n\nCXX_FLAGS = " + flags
+                      + "\n\nCXX_DEFINES = -DTARGET\n\nCXX_INCLUDES = -I/usr/include/qt5\n");
+            ninja += "# Object build statements for EXECUTABLE target " + name.toUtf8() + "\n\n";
+            for (int i = t; i < fileCount; i += targetCount) {
+                ninja += "build CMakeFiles/" + name.toUtf8() + ".dir/file_" + QByteArray::number(i)
+                        + ".cpp.o: CXX_COMPILER__" + name.toUtf8() + " " + sourceBase(i).toUtf8() + ".cpp\n"
+                        "  FLAGS = " + flags + "\n  DEFINES = -DTARGET\n\n";
+            }
+        }
+        writeFile(build + QLatin1String("/build.ninja"), ninja);
+    }
+
+    QTemporaryDir m_dir;
+};
+
+SyntheticProject &syntheticProject()
+{
+    static std::unique_ptr<SyntheticProject> project;
+    if (!project)
+        project.reset(new SyntheticProject);
+    return *project;
+}
+
+// Times the QBENCHMARK iterations itself so that results can be tracked outside of QTest:
+class BenchmarkResult
+{
+public:
+    explicit BenchmarkResult(const char *name) : m_name(name) { }
+
+    ~BenchmarkResult()
+    {
+        const QString fileName = QString::fromLocal8Bit(qgetenv("QTC_CMAKE_BENCH_RESULTS"));
+        if (fileName.isEmpty() || m_iterations == 0)
+            return;
+        const SyntheticProject &project = syntheticProject();
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+            return;
+        file.write("{\"benchmark\":\"" + QByteArray(m_name)
+                   + "\",\"files\":" + QByteArray::number(project.fileCount)
+                   + ",\"targets\":" + QByteArray::number(project.targetCount)
+                   + ",\"depth\":" + QByteArray::number(project.depth)
+                   + ",\"iterations\":" + QByteArray::number(m_iterations)
+                   + ",\"msecsPerIteration\":"
+                   + QByteArray::number(m_nsecs / 1000000.0 / m_iterations, 'f', 3) + "}\n");
+    }
+
+    void start() { m_timer.start(); }
+    void stop() { m_nsecs += m_timer.nsecsElapsed(); ++m_iterations; }
+
+private:
+    const char *m_name;
+    QElapsedTimer m_timer;
+    qint64 m_nsecs = 0;
+    int m_iterations = 0;
+};
+
+Utils::FileName identityMapper(const Utils::FileName &fileName)
+{
+    return fileName;
+}
+
+} // namespace
+
+void CMakeBenchmarks::treeBuilder()
+{
+    SyntheticProject &project = syntheticProject();
+    BenchmarkResult result("treeBuilder");
+    TreeBuilder builder;
+    QBENCHMARK {
+        result.start();
+        builder.startScanning(project.sourceDirectory);
+        builder.wait();
+        result.stop();
+    }
+}
+
+void CMakeBenchmarks::cbpParser()
+{
+    SyntheticProject &project = syntheticProject();
+    BenchmarkResult result("cbpParser");
+    QBENCHMARK {
+        result.start();
+        CMakeCbpParser parser;
+        QVERIFY(parser.parseCbpFile(identityMapper, project.cbpFile, project.sourceDirectory));
+        result.stop();
+        QCOMPARE(parser.buildTargets().count(), project.targetCount);
+        QCOMPARE(parser.fileList().count(), project.fileCount);
+        qDeleteAll(parser.fileList());
+        qDeleteAll(parser.cmakeFileList());
+    }
+}
+
+void CMakeBenchmarks::parseConfiguration()
+{
+    SyntheticProject &project = syntheticProject();
+    BenchmarkResult result("parseConfiguration");
+    QBENCHMARK {
+        result.start();
+        QString errorMessage;
+        const CMakeConfig config = BuildDirManager::parseConfiguration(project.cacheFile, &errorMessage);
+        result.stop();
+        QVERIFY(errorMessage.isEmpty());
+        QVERIFY(!config.isEmpty());
+    }
+}
+
+void CMakeBenchmarks::flagExtraction()
+{
+    SyntheticProject &project = syntheticProject();
+    CMakeCbpParser parser;
+    QVERIFY(parser.parseCbpFile(identityMapper, project.cbpFile, project.sourceDirectory));
+    const QList<CMakeBuildTarget> targets = parser.buildTargets();
+    qDeleteAll(parser.fileList());
+    qDeleteAll(parser.cmakeFileList());
+
+    BenchmarkResult result("flagExtraction");
+    QBENCHMARK {
+        result.start();
+        QHash<QString, QStringList> makeCache;
+        foreach (const CMakeBuildTarget &target, targets)
+            BuildDirManager::extractFlagsFromMake(target, makeCache, ToolChain::Language::Cxx);
+        QHash<QString, QStringList> ninjaCache;
+        BuildDirManager::extractFlagsFromNinja(project.buildDirectory, ninjaCache, ToolChain::Language::Cxx);
+        result.stop();
+        QCOMPARE(makeCache.count(), project.targetCount);
+        QCOMPARE(ninjaCache.count(), project.targetCount);
+    }
+}
+
+void CMakeBenchmarks::projectTree()
+{
+    SyntheticProject &project = syntheticProject();
+    // Second update after a file was renamed, which should only touch a few nodes:
+    QList<FileNodeInfo> renamed = project.cmakeFiles;
+    renamed.first() = FileNodeInfo(Utils::FileName::fromString(
+                                       renamed.first().filePath().toString() + QLatin1String(".renamed.cpp")),
+                                   SourceType, false);
+    Utils::sort(renamed);
+
+    BenchmarkResult result("projectTree");
+    QBENCHMARK {
+        result.start();
+        FolderNode root(project.sourceDirectory);
+        BuildDirManager::updateProjectTree(&root, project.cmakeFiles, project.treeFiles);
+        BuildDirManager::updateProjectTree(&root, renamed, project.treeFiles);
+        result.stop();
+    }
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
+#ifdef CMAKE_STANDALONE_BENCHMARKS
+QTEST_MAIN(CMakeProjectManager::Internal::CMakeBenchmarks)
+#endif
+
+#endif // WITH_TESTS || CMAKE_STANDALONE_BENCHMARKS
@@ -0,0 +1,45 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <QObject>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Benchmarks of the project loading steps against a synthetic project. They run as the
+// standalone benchmarks/ executable, and with the plugin tests (-test CMakeProjectManager2)
+// if QTC_CMAKE_BENCH is set.
+//
+// The scale can be set with QTC_CMAKE_BENCH_FILES, QTC_CMAKE_BENCH_TARGETS and
+// QTC_CMAKE_BENCH_DEPTH. If QTC_CMAKE_BENCH_RESULTS names a file, one JSON object per
+// benchmark is appended to it.
+class CMakeBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void treeBuilder();
+    void cbpParser();
+    void parseConfiguration();
+    void flagExtraction();
+    void projectTree();
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -152,6 +152,10 @@ void CMakeBuildConfiguration::ctor()
 
     connect(m_buildDirManager, &BuildDirManager::dataAvailable,
             this, &CMakeBuildConfiguration::dataAvailable);
+    connect(m_buildDirManager, &BuildDirManager::codeModelDataAvailable,
+            this, &CMakeBuildConfiguration::codeModelDataAvailable);
+    connect(m_buildDirManager, &BuildDirManager::cmakeRunFinished,
+            this, &CMakeBuildConfiguration::configureFinished);
     connect(m_buildDirManager, &BuildDirManager::errorOccured,
             this, &CMakeBuildConfiguration::setError);
     connect(m_buildDirManager, &BuildDirManager::configurationStarted,
@@ -164,6 +168,7 @@ void CMakeBuildConfiguration::ctor()
 
     connect(this, &CMakeBuildConfiguration::parsingStarted, project, &CMakeProject::handleParsingStarted);
     connect(this, &CMakeBuildConfiguration::dataAvailable, project, &CMakeProject::updateProjectData);
+    connect(this, &CMakeBuildConfiguration::codeModelDataAvailable, project, &CMakeProject::updateCodeModelData);
 }
 
 void CMakeBuildConfiguration::maybeForceReparse()
@@ -176,6 +181,16 @@ bool CMakeBuildConfiguration::isParsing() const
     return m_buildDirManager && m_buildDirManager->isParsing();
 }
 
+bool CMakeBuildConfiguration::hasData() const
+{
+    return m_buildDirManager && m_buildDirManager->hasData();
+}
+
+bool CMakeBuildConfiguration::hasCodeModelData() const
+{
+    return m_buildDirManager && m_buildDirManager->hasCodeModelData();
+}
+
 void CMakeBuildConfiguration::resetData()
 {
     m_buildDirManager->resetData();
@@ -200,6 +215,22 @@ void CMakeBuildConfiguration::runCMake()
     m_buildDirManager->forceReparse();
 }
 
+bool CMakeBuildConfiguration::configure()
+{
+    return m_buildDirManager && m_buildDirManager->configure();
+}
+
+void CMakeBuildConfiguration::cancelConfigure()
+{
+    if (m_buildDirManager)
+        m_buildDirManager->stopProcess();
+}
+
+bool CMakeBuildConfiguration::isConfigureNeededFor(const QStringList &filePaths) const
+{
+    return !m_buildDirManager || m_buildDirManager->isConfigureNeededFor(filePaths);
+}
+
 void CMakeBuildConfiguration::clearCache()
 {
     if (m_buildDirManager)
@@ -214,6 +245,14 @@ QList<CMakeBuildTarget> CMakeBuildConfiguration::buildTargets() const
     return m_buildDirManager->buildTargets();
 }
 
+const GeneratedFilesIndex *CMakeBuildConfiguration::generatedFiles() const
+{
+    if (!m_buildDirManager || m_buildDirManager->isParsing())
+        return nullptr;
+
+    return &m_buildDirManager->generatedFiles();
+}
+
 void CMakeBuildConfiguration::generateProjectTree(CMakeProjectNode *root, const QList<FileNodeInfo> &treeFiles) const
 {
     if (!m_buildDirManager || m_buildDirManager->isParsing())
@@ -222,9 +261,11 @@ void CMakeBuildConfiguration::generateProjectTree(CMakeProjectNode *root, const
     return m_buildDirManager->generateProjectTree(root, treeFiles);
 }
 
-QSet<Core::Id> CMakeBuildConfiguration::updateCodeModel(CppTools::ProjectPartBuilder &ppBuilder)
+QSet<Core::Id> CMakeBuildConfiguration::updateCodeModel(CppTools::ProjectInfo &pinfo,
+                                                        CppTools::ProjectPartBuilder &ppBuilder,
+                                                        bool *changed)
 {
-    return m_buildDirManager->updateCodeModel(ppBuilder);
+    return m_buildDirManager->updateCodeModel(pinfo, ppBuilder, changed);
 }
 
 FileName CMakeBuildConfiguration::shadowBuildDirectory(const FileName &projectFilePath,
@@ -253,9 +294,9 @@ QList<ConfigModel::DataItem> CMakeBuildConfiguration::completeCMakeConfiguration
     return Utils::transform(m_completeConfigurationCache,
                             [this](const CMakeConfigItem &i) {
         ConfigModel::DataItem j;
-        j.key = QString::fromUtf8(i.key);
+        j.key = CMakeConfigItem::keyString(i.key);
         j.value = QString::fromUtf8(i.value);
-        j.description = QString::fromUtf8(i.documentation);
+        j.description = CMakeConfigItem::documentationString(i.documentation);
         j.values = i.values;
 
         j.isAdvanced = i.isAdvanced || i.type == CMakeConfigItem::INTERNAL;
@@ -288,9 +329,9 @@ void CMakeBuildConfiguration::setCurrentCMakeConfiguration(const QList<ConfigMod
 
     const CMakeConfig newConfig = Utils::transform(items, [](const ConfigModel::DataItem &i) {
         CMakeConfigItem ni;
-        ni.key = i.key.toUtf8();
+        ni.key = CMakeConfigItem::internedKey(i.key.toUtf8());
         ni.value = i.value.toUtf8();
-        ni.documentation = i.description.toUtf8();
+        ni.documentation = CMakeConfigItem::internedDocumentation(i.description.toUtf8());
         ni.isAdvanced = i.isAdvanced;
         ni.values = i.values;
         switch (i.type) {
@@ -33,7 +33,10 @@
 #include <projectexplorer/buildconfiguration.h>
 #include <projectexplorer/abi.h>
 
-namespace CppTools { class ProjectPartBuilder; }
+namespace CppTools {
+class ProjectInfo;
+class ProjectPartBuilder;
+} // namespace CppTools
 namespace ProjectExplorer { class ToolChain; }
 
 namespace CMakeProjectManager {
@@ -45,6 +48,7 @@ namespace Internal {
 class BuildDirManager;
 class CMakeBuildConfigurationFactory;
 class CMakeBuildSettingsWidget;
+class GeneratedFilesIndex;
 
 class CMakeBuildConfiguration : public ProjectExplorer::BuildConfiguration
 {
@@ -77,17 +81,24 @@ public:
     QString warning() const;
 
     bool isParsing() const;
+    bool hasData() const;
+    bool hasCodeModelData() const;
 
     void maybeForceReparse();
     void resetData();
     bool persistCMakeState();
     bool updateCMakeStateBeforeBuild();
     void runCMake();
+    bool configure();
+    void cancelConfigure();
+    bool isConfigureNeededFor(const QStringList &filePaths) const;
     void clearCache();
 
     QList<CMakeBuildTarget> buildTargets() const;
+    const GeneratedFilesIndex *generatedFiles() const;
     void generateProjectTree(CMakeProjectNode *root, const QList<Internal::FileNodeInfo> &treeFiles) const;
-    QSet<Core::Id> updateCodeModel(CppTools::ProjectPartBuilder &ppBuilder);
+    QSet<Core::Id> updateCodeModel(CppTools::ProjectInfo &pinfo, CppTools::ProjectPartBuilder &ppBuilder,
+                                   bool *changed = nullptr);
 
     static Utils::FileName
     shadowBuildDirectory(const Utils::FileName &projectFilePath, const ProjectExplorer::Kit *k,
@@ -99,6 +110,8 @@ signals:
 
     void parsingStarted();
     void dataAvailable();
+    void codeModelDataAvailable();
+    void configureFinished();
 
 protected:
     CMakeBuildConfiguration(ProjectExplorer::Target *parent, CMakeBuildConfiguration *source);
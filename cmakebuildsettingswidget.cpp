@@ -26,6 +26,7 @@
 #include "cmakebuildsettingswidget.h"
 
 #include "configmodel.h"
+#include "configmodelfilter.h"
 #include "configmodelitemdelegate.h"
 #include "cmakeproject.h"
 #include "cmakebuildconfiguration.h"
@@ -47,7 +48,6 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QPushButton>
-#include <QSortFilterProxyModel>
 #include <QSpacerItem>
 #include <QMenu>
 #include <QGroupBox>
@@ -64,7 +64,7 @@ namespace Internal {
 CMakeBuildSettingsWidget::CMakeBuildSettingsWidget(CMakeBuildConfiguration *bc) :
     m_buildConfiguration(bc),
     m_configModel(new ConfigModel(this)),
-    m_configFilterModel(new QSortFilterProxyModel)
+    m_configFilterModel(new ConfigModelFilter(this))
 {
     QTC_CHECK(bc);
 
@@ -127,6 +127,14 @@ CMakeBuildSettingsWidget::CMakeBuildSettingsWidget(CMakeBuildConfiguration *bc)
     ++row;
     mainLayout->addItem(new QSpacerItem(20, 10), row, 0);
 
+    ++row;
+    m_filterEdit = new Utils::FancyLineEdit;
+    m_filterEdit->setFiltering(true);
+    m_filterEdit->setToolTip(tr("Words are matched against the start of words in the key, value and description.\n"
+                                "\"*text\" matches a substring, \"key:text\" searches keys only,\n"
+                                "\"type:bool|string|path|file\" filters by type and \"changed:yes|no\" by changed state."));
+    mainLayout->addWidget(m_filterEdit, row, 0, 1, 2);
+
     ++row;
     auto tree = new Utils::TreeView;
     connect(tree, &Utils::TreeView::activated,
@@ -245,9 +253,15 @@ CMakeBuildSettingsWidget::CMakeBuildSettingsWidget(CMakeBuildConfiguration *bc)
             this, &CMakeBuildSettingsWidget::updateButtonState);
     connect(m_configModel, &QAbstractItemModel::modelReset,
             this, &CMakeBuildSettingsWidget::updateButtonState);
+    connect(m_configModel, &QAbstractItemModel::rowsInserted,
+            this, &CMakeBuildSettingsWidget::updateButtonState);
+    connect(m_configModel, &QAbstractItemModel::rowsRemoved,
+            this, &CMakeBuildSettingsWidget::updateButtonState);
 
     connect(m_showAdvancedCheckBox, &QCheckBox::stateChanged,
             this, &CMakeBuildSettingsWidget::updateAdvancedCheckBox);
+    connect(m_filterEdit, &QLineEdit::textChanged,
+            m_configFilterModel, &ConfigModelFilter::setSearchText);
 
     connect(m_resetButton, &QPushButton::clicked, m_configModel, &ConfigModel::resetAllChanges);
     connect(m_reconfigureButton, &QPushButton::clicked, this, [this]() {
@@ -303,6 +317,7 @@ void CMakeBuildSettingsWidget::setError(const QString &message)
     m_errorMessageLabel->setToolTip(message);
 
     m_configView->setVisible(!showError);
+    m_filterEdit->setVisible(!showError);
     m_editButton->setVisible(!showError);
     m_resetButton->setVisible(!showError);
     m_showAdvancedCheckBox->setVisible(!showError);
@@ -39,7 +39,6 @@ class QCheckBox;
 class QLabel;
 class QPushButton;
 class QTreeView;
-class QSortFilterProxyModel;
 class QMenu;
 class QGroupBox;
 QT_END_NAMESPACE
@@ -51,6 +50,7 @@ class ConfigModel;
 namespace Internal {
 
 class CMakeBuildConfiguration;
+class ConfigModelFilter;
 
 class CMakeBuildSettingsWidget : public ProjectExplorer::NamedWidget
 {
@@ -71,7 +71,8 @@ private:
     CMakeBuildConfiguration *m_buildConfiguration;
     QTreeView *m_configView;
     ConfigModel *m_configModel;
-    QSortFilterProxyModel *m_configFilterModel;
+    ConfigModelFilter *m_configFilterModel;
+    Utils::FancyLineEdit *m_filterEdit;
     Utils::ProgressIndicator *m_progressIndicator;
     QPushButton *m_addButton;
     QMenu *m_addButtonMenu;
@@ -30,10 +30,86 @@
 #include <utils/macroexpander.h>
 #include <utils/qtcassert.h>
 
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
 #include <QString>
+#include <QtAlgorithms>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace CMakeProjectManager {
 
+// --------------------------------------------------------------------
+// Intern tables:
+// --------------------------------------------------------------------
+
+namespace {
+
+class InternTable
+{
+public:
+    QByteArray intern(const QByteArray &data)
+    {
+        if (data.isEmpty())
+            return QByteArray();
+
+        QMutexLocker locker(&m_mutex);
+        auto it = m_data.constFind(data);
+        if (it != m_data.constEnd())
+            return *it;
+        // data might be a raw view into a temporary buffer:
+        const QByteArray copy(data.constData(), data.size());
+        m_data.insert(copy);
+        return copy;
+    }
+
+    QString string(const QByteArray &data)
+    {
+        if (data.isEmpty())
+            return QString();
+
+        QMutexLocker locker(&m_mutex);
+        auto it = m_strings.constFind(data);
+        if (it != m_strings.constEnd())
+            return *it;
+        const QString result = QString::fromUtf8(data);
+        m_strings.insert(QByteArray(data.constData(), data.size()), result);
+        return result;
+    }
+
+    void releaseUnused()
+    {
+        QMutexLocker locker(&m_mutex);
+        // Only referenced by the table itself:
+        for (auto it = m_data.begin(); it != m_data.end(); ) {
+            if (it->isDetached())
+                it = m_data.erase(it);
+            else
+                ++it;
+        }
+        for (auto it = m_strings.begin(); it != m_strings.end(); ) {
+            if (it.value().isDetached())
+                it = m_strings.erase(it);
+            else
+                ++it;
+        }
+    }
+
+private:
+    QMutex m_mutex;
+    QSet<QByteArray> m_data;
+    QHash<QByteArray, QString> m_strings;
+};
+
+Q_GLOBAL_STATIC(InternTable, keyTable)
+Q_GLOBAL_STATIC(InternTable, documentationTable)
+
+} // namespace
+
 // --------------------------------------------------------------------
 // CMakeConfigItem:
 // --------------------------------------------------------------------
@@ -47,13 +123,39 @@ CMakeConfigItem::CMakeConfigItem(const CMakeConfigItem &other) :
 
 CMakeConfigItem::CMakeConfigItem(const QByteArray &k, Type t,
                                  const QByteArray &d, const QByteArray &v) :
-    key(k), type(t), value(v), documentation(d)
+    key(internedKey(k)), type(t), value(v), documentation(internedDocumentation(d))
 { }
 
 CMakeConfigItem::CMakeConfigItem(const QByteArray &k, const QByteArray &v) :
-    key(k), value(v)
+    key(internedKey(k)), value(v)
 { }
 
+QByteArray CMakeConfigItem::internedKey(const QByteArray &key)
+{
+    return keyTable()->intern(key);
+}
+
+QByteArray CMakeConfigItem::internedDocumentation(const QByteArray &documentation)
+{
+    return documentationTable()->intern(documentation);
+}
+
+void CMakeConfigItem::releaseUnusedInternedData()
+{
+    keyTable()->releaseUnused();
+    documentationTable()->releaseUnused();
+}
+
+QString CMakeConfigItem::keyString(const QByteArray &key)
+{
+    return keyTable()->string(key);
+}
+
+QString CMakeConfigItem::documentationString(const QByteArray &documentation)
+{
+    return documentationTable()->string(documentation);
+}
+
 QByteArray CMakeConfigItem::valueOf(const QByteArray &key, const QList<CMakeConfigItem> &input)
 {
     for (auto it = input.constBegin(); it != input.constEnd(); ++it) {
@@ -73,12 +175,36 @@ QString CMakeConfigItem::expandedValueOf(const ProjectExplorer::Kit *k, const QB
     return QString();
 }
 
-static QString between(const QString::ConstIterator it1, const QString::ConstIterator it2)
+// Returns the position of the next ';', '\\', '[' or ']' in data[from, end), or end.
+static int nextSpecialChar(const ushort *data, int from, int end)
 {
-    QString result;
-    for (auto it = it1; it != it2; ++it)
-        result.append(*it);
-    return result;
+#if defined(__SSE2__)
+    const __m128i semicolon = _mm_set1_epi16(';');
+    const __m128i backslash = _mm_set1_epi16('\\');
+    const __m128i openBracket = _mm_set1_epi16('[');
+    const __m128i closeBracket = _mm_set1_epi16(']');
+    for (; from + 8 <= end; from += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        const __m128i hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi16(chunk, semicolon), _mm_cmpeq_epi16(chunk, backslash)),
+                    _mm_or_si128(_mm_cmpeq_epi16(chunk, openBracket), _mm_cmpeq_epi16(chunk, closeBracket)));
+        const uint mask = uint(_mm_movemask_epi8(hits));
+        if (mask)
+            return from + int(qCountTrailingZeroBits(mask) / 2);
+    }
+#endif
+    for (; from < end; ++from) {
+        switch (data[from]) {
+        case ';':
+        case '\\':
+        case '[':
+        case ']':
+            return from;
+        default:
+            break;
+        }
+    }
+    return end;
 }
 
 QStringList CMakeConfigItem::cmakeSplitValue(const QString &in, bool keepEmpty)
@@ -87,49 +213,54 @@ QStringList CMakeConfigItem::cmakeSplitValue(const QString &in, bool keepEmpty)
     if (in.isEmpty())
         return newArgs;
 
+    const ushort *data = in.utf16();
+    const int size = in.size();
+
     int squareNesting = 0;
+    int last = 0;
+    // Only used once an escaped semicolon was removed from the current argument, all
+    // other arguments are copied out of the input in one go:
     QString newArg;
-    auto last = in.constBegin();
-    for (auto c = in.constBegin(); c != in.constEnd(); ++c) {
-        switch (c->unicode()) {
-        case '\\': {
-            auto next = c + 1;
-            if (next != in.constEnd() && *next == ';') {
-                newArg.append(between(last, c));
-                last = next;
-                c = next;
+    auto addArgument = [&](int end) {
+        if (newArg.isEmpty()) {
+            if (end > last || keepEmpty)
+                newArgs.append(in.mid(last, end - last));
+        } else {
+            newArg.append(in.midRef(last, end - last));
+            newArgs.append(newArg);
+            newArg.clear();
+        }
+    };
+
+    for (int pos = nextSpecialChar(data, 0, size); pos < size;
+         pos = nextSpecialChar(data, pos + 1, size)) {
+        switch (data[pos]) {
+        case '\\':
+            if (pos + 1 < size && data[pos + 1] == ';') {
+                // Drop the backslash, keep the semicolon as part of the argument:
+                newArg.append(in.midRef(last, pos - last));
+                last = ++pos;
             }
-        } break;
-        case '[': {
+            break;
+        case '[':
             ++squareNesting;
-        } break;
-        case ']': {
+            break;
+        case ']':
             --squareNesting;
-        } break;
-        case ';': {
-            // Break the string here if we are not nested inside square
-            // brackets.
+            break;
+        case ';':
+            // Break the string here if we are not nested inside square brackets.
             if (squareNesting == 0) {
-              newArg.append(between(last, c));
-              // Skip over the semicolon
-              last = c + 1;
-              if (!newArg.isEmpty() || keepEmpty) {
-                // Add the last argument if the string is not empty.
-                newArgs.append(newArg);
-                newArg.clear();
-              }
+                addArgument(pos);
+                // Skip over the semicolon
+                last = pos + 1;
             }
-        } break;
-        default: {
-            // Just append this character.
-        } break;
+            break;
+        default:
+            break;
         }
     }
-    newArg.append(between(last, in.constEnd()));
-    if (!newArg.isEmpty() || keepEmpty) {
-        // Add the last argument if the string is not empty.
-        newArgs.append(newArg);
-    }
+    addArgument(size);
 
     return newArgs;
 }
@@ -207,7 +338,7 @@ CMakeConfigItem CMakeConfigItem::fromString(const QString &s)
         else if (type == QLatin1String("STATIC"))
             t = CMakeConfigItem::STATIC;
 
-        item.key = key.toUtf8();
+        item.key = internedKey(key.toUtf8());
         item.type = t;
         item.value = value.toUtf8();
     }
@@ -321,6 +452,26 @@ void CMakeProjectPlugin::testCMakeSplitValue()
     QCOMPARE(expectedOutput, realOutput);
 }
 
+void CMakeProjectPlugin::testCMakeSplitValueBenchmark()
+{
+    // CMAKE_PREFIX_PATH-like value with 10000 entries, some of them escaped:
+    QStringList entries;
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 100 == 0)
+            entries.append(QString::fromLatin1("/opt/sdk/escaped\\;entry_%1").arg(i));
+        else
+            entries.append(QString::fromLatin1("/opt/sdk/packages/package_%1/lib/cmake").arg(i));
+    }
+    const QString input = entries.join(QLatin1Char(';'));
+
+    QStringList result;
+    QBENCHMARK {
+        result = CMakeConfigItem::cmakeSplitValue(input);
+    }
+    QCOMPARE(result.size(), entries.size());
+    QCOMPARE(result.at(100), QString::fromLatin1("/opt/sdk/escaped;entry_100"));
+}
+
 } // namespace Internal
 #endif
 
@@ -52,6 +52,15 @@ public:
     static QStringList cmakeSplitValue(const QString &in, bool keepEmpty = false);
     bool isNull() const { return key.isEmpty(); }
 
+    // Keys and documentation are shared process wide: all items (of all build
+    // configurations) with the same key or documentation refer to the same data.
+    // Copies are kept until releaseUnusedInternedData().
+    static QByteArray internedKey(const QByteArray &key);
+    static QByteArray internedDocumentation(const QByteArray &documentation);
+    static void releaseUnusedInternedData();
+    static QString keyString(const QByteArray &key);
+    static QString documentationString(const QByteArray &documentation);
+
     QString expandedValue(const ProjectExplorer::Kit *k) const;
     QString expandedValue(const Utils::MacroExpander *expander) const;
 
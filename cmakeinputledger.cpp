@@ -0,0 +1,190 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "cmakeinputledger.h"
+
+#include <utils/fileutils.h>
+
+#include <QCryptographicHash>
+#include <QFile>
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <utils/runextensions.h>
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QTest>
+#endif
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+const char LEDGER_FILE_NAME[] = "CMakeFiles/QtCreatorInputs.sha1";
+const char LEDGER_HEADER[] = "# Qt Creator cmake input ledger 1";
+
+} // namespace
+
+Utils::FileName CMakeInputLedger::ledgerFile(const Utils::FileName &buildDirectory)
+{
+    return Utils::FileName(buildDirectory).appendPath(QLatin1String(LEDGER_FILE_NAME));
+}
+
+CMakeInputLedger::Hashes CMakeInputLedger::load(const Utils::FileName &ledgerFile)
+{
+    Hashes result;
+    QFile file(ledgerFile.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    if (file.readLine().trimmed() != LEDGER_HEADER)
+        return result;
+
+    // One "<hex hash> <path>" entry per line:
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const int space = line.indexOf(' ');
+        if (space <= 0)
+            continue;
+        const QByteArray path = line.mid(space + 1).trimmed();
+        if (path.isEmpty())
+            continue;
+        result.insert(Utils::FileName::fromUtf8(path.constData(), path.size()),
+                      QByteArray::fromHex(line.left(space)));
+    }
+    return result;
+}
+
+bool CMakeInputLedger::save(const Utils::FileName &ledgerFile, const Hashes &hashes)
+{
+    QByteArray data = LEDGER_HEADER;
+    data.append('\n');
+    for (auto it = hashes.constBegin(); it != hashes.constEnd(); ++it) {
+        if (it.value().isEmpty())
+            continue;
+        data.append(it.value().toHex());
+        data.append(' ');
+        data.append(it.key().toString().toUtf8());
+        data.append('\n');
+    }
+
+    Utils::FileSaver saver(ledgerFile.toString(), QIODevice::Text);
+    saver.write(data);
+    return saver.finalize();
+}
+
+void CMakeInputLedger::hashFiles(QFutureInterface<Hashes> &fi, const QList<Utils::FileName> &files)
+{
+    Hashes result;
+    result.reserve(files.count());
+    foreach (const Utils::FileName &fileName, files) {
+        if (fi.isCanceled())
+            return;
+
+        QByteArray hash;
+        QFile file(fileName.toString());
+        if (file.open(QIODevice::ReadOnly)) {
+            QCryptographicHash hasher(QCryptographicHash::Sha1);
+            if (hasher.addData(&file))
+                hash = hasher.result();
+        }
+        result.insert(fileName, hash);
+    }
+    fi.reportResult(result);
+}
+
+bool CMakeInputLedger::hasChanges(const Hashes &recorded, const Hashes &current)
+{
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        const QByteArray hash = recorded.value(it.key());
+        if (hash.isEmpty() || hash != it.value())
+            return true;
+    }
+    return false;
+}
+
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testCMakeInputLedger()
+{
+    QTemporaryDir buildDir;
+    QVERIFY(buildDir.isValid());
+    QVERIFY(QDir(buildDir.path()).mkpath("CMakeFiles"));
+
+    auto writeFile = [&buildDir](const QString &name, const QByteArray &contents) {
+        const Utils::FileName fileName = Utils::FileName::fromString(buildDir.path()).appendPath(name);
+        QFile file(fileName.toString());
+        if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size())
+            return Utils::FileName();
+        return fileName;
+    };
+    auto hashFiles = [](const QList<Utils::FileName> &files) {
+        return Utils::runAsync(&CMakeInputLedger::hashFiles, files).result();
+    };
+
+    const Utils::FileName lists = writeFile("CMakeLists.txt", "project(test)\n");
+    const Utils::FileName module = writeFile("module.cmake", "set(A b)\n");
+    QVERIFY(!lists.isEmpty() && !module.isEmpty());
+    const CMakeInputLedger::Hashes hashes = hashFiles({ lists, module });
+    QCOMPARE(hashes.count(), 2);
+    QVERIFY(!hashes.value(lists).isEmpty());
+    QVERIFY(hashes.value(lists) != hashes.value(module));
+
+    // Round trip:
+    const Utils::FileName ledger = CMakeInputLedger::ledgerFile(Utils::FileName::fromString(buildDir.path()));
+    QVERIFY(CMakeInputLedger::save(ledger, hashes));
+    const CMakeInputLedger::Hashes recorded = CMakeInputLedger::load(ledger);
+    QCOMPARE(recorded, hashes);
+    QVERIFY(!CMakeInputLedger::hasChanges(recorded, hashes));
+
+    // A newer timestamp alone is no change:
+    QVERIFY(!writeFile("module.cmake", "set(A b)\n").isEmpty());
+    QVERIFY(!CMakeInputLedger::hasChanges(recorded, hashFiles({ lists, module })));
+
+    // Changed content:
+    QVERIFY(!writeFile("module.cmake", "set(A c)\n").isEmpty());
+    QVERIFY(CMakeInputLedger::hasChanges(recorded, hashFiles({ lists, module })));
+
+    // A file that was not recorded:
+    const Utils::FileName other = writeFile("other.cmake", "set(B c)\n");
+    QVERIFY(!other.isEmpty());
+    QVERIFY(CMakeInputLedger::hasChanges(recorded, hashFiles({ lists, other })));
+
+    // Unreadable files get an empty hash, which is never recorded and always a change:
+    const Utils::FileName missing = Utils::FileName::fromString(buildDir.path()).appendPath("missing.cmake");
+    const CMakeInputLedger::Hashes withMissing = hashFiles({ lists, missing });
+    QVERIFY(withMissing.contains(missing));
+    QVERIFY(withMissing.value(missing).isEmpty());
+    QVERIFY(CMakeInputLedger::hasChanges(recorded, withMissing));
+    QVERIFY(CMakeInputLedger::save(ledger, withMissing));
+    QVERIFY(!CMakeInputLedger::load(ledger).contains(missing));
+    QVERIFY(CMakeInputLedger::hasChanges(CMakeInputLedger::load(ledger), withMissing));
+
+    // A ledger without the header is ignored:
+    QFile file(ledger.toString());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(hashes.value(lists).toHex() + ' ' + lists.toString().toUtf8() + '\n');
+    file.close();
+    QVERIFY(CMakeInputLedger::load(ledger).isEmpty());
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,51 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QByteArray>
+#include <QFutureInterface>
+#include <QHash>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Content hashes of the cmake input files, recorded after each successful cmake run and
+// kept in the build directory. A newer timestamp alone is not a reason to rerun cmake
+// anymore: the content has to differ from what cmake saw last time.
+class CMakeInputLedger
+{
+public:
+    using Hashes = QHash<Utils::FileName, QByteArray>;
+
+    static Utils::FileName ledgerFile(const Utils::FileName &buildDirectory);
+
+    static Hashes load(const Utils::FileName &ledgerFile);
+    static bool save(const Utils::FileName &ledgerFile, const Hashes &hashes);
+
+    // Reads and hashes files, meant to run in a worker thread. Files that can not be read
+    // get an empty hash.
+    static void hashFiles(QFutureInterface<Hashes> &fi, const QList<Utils::FileName> &files);
+
+    // True if any file in current was not recorded or has a different hash:
+    static bool hasChanges(const Hashes &recorded, const Hashes &current);
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -36,11 +36,95 @@
 
 #include <utils/algorithm.h>
 
+#include <QMutexLocker>
+
+#include <algorithm>
+
 using namespace CMakeProjectManager;
 using namespace CMakeProjectManager::Internal;
 using namespace ProjectExplorer;
 using namespace Utils;
 
+namespace {
+
+const int EXACT_MATCH_SCORE = 1000;
+const int PREFIX_MATCH_SCORE = 800;
+const int SUBSTRING_MATCH_SCORE = 500;
+const int FUZZY_MATCH_SCORE = 300;
+const int MAX_RECENT_USE_BONUS = 150;
+
+QString recentUseKey(const QString &projectFilePath, const QString &title)
+{
+    return projectFilePath + QLatin1Char('\n') + title;
+}
+
+// Start of a "word" in camelCase, snake_case, dash-case or dotted target names.
+bool isWordStart(const QString &title, int i)
+{
+    if (i == 0)
+        return true;
+    const QChar prev = title.at(i - 1);
+    const QChar cur = title.at(i);
+    if (!prev.isLetterOrNumber())
+        return true;
+    if (cur.isUpper() && !prev.isUpper())
+        return true;
+    return cur.isDigit() && !prev.isDigit();
+}
+
+// Matches needle characters in order, preferring the start of words. Returns -1 if the
+// needle is not a subsequence of the title.
+int fuzzyScore(const QString &title, const QString &needle, bool preferWordStarts)
+{
+    int score = FUZZY_MATCH_SCORE;
+    int pos = 0;
+    for (const QChar c : needle) {
+        const QChar lower = c.toLower();
+        int found = -1;
+        if (preferWordStarts) {
+            for (int i = pos; i < title.size(); ++i) {
+                if (isWordStart(title, i) && title.at(i).toLower() == lower) {
+                    found = i;
+                    break;
+                }
+            }
+        }
+        if (found == -1) {
+            found = title.indexOf(c, pos, Qt::CaseInsensitive);
+            if (found == -1)
+                return -1;
+            score -= found - pos; // penalize gaps
+        } else {
+            score += 20;
+        }
+        pos = found + 1;
+    }
+    return qBound(1, score, SUBSTRING_MATCH_SCORE - 1);
+}
+
+int matchScore(const QString &title, const QString &needle)
+{
+    if (needle.isEmpty())
+        return 1;
+    if (title.compare(needle, Qt::CaseInsensitive) == 0)
+        return EXACT_MATCH_SCORE;
+    if (title.startsWith(needle))
+        return PREFIX_MATCH_SCORE;
+    if (title.startsWith(needle, Qt::CaseInsensitive))
+        return PREFIX_MATCH_SCORE - 50;
+
+    const int index = title.indexOf(needle, 0, Qt::CaseInsensitive);
+    if (index != -1)
+        return SUBSTRING_MATCH_SCORE + (isWordStart(title, index) ? 100 : 0) - qMin(index, 50);
+
+    const int score = fuzzyScore(title, needle, true);
+    if (score != -1)
+        return score;
+    return fuzzyScore(title, needle, false);
+}
+
+} // namespace
+
 CMakeLocatorFilter::CMakeLocatorFilter()
 {
     setId("Build CMake target");
@@ -48,37 +132,73 @@ CMakeLocatorFilter::CMakeLocatorFilter()
     setShortcutString(QLatin1String("cm"));
     setPriority(High);
 
+    connect(SessionManager::instance(), &SessionManager::projectAdded,
+            this, &CMakeLocatorFilter::projectAdded);
     connect(SessionManager::instance(), &SessionManager::projectAdded,
             this, &CMakeLocatorFilter::projectListUpdated);
     connect(SessionManager::instance(), &SessionManager::projectRemoved,
             this, &CMakeLocatorFilter::projectListUpdated);
 
     // Initialize the filter
+    foreach (Project *p, SessionManager::projects())
+        projectAdded(p);
     projectListUpdated();
 }
 
-void CMakeLocatorFilter::prepareSearch(const QString &entry)
+QList<Core::LocatorFilterEntry> CMakeLocatorFilter::matchesFor(QFutureInterface<Core::LocatorFilterEntry> &future, const QString &entry)
 {
-    m_result.clear();
-    foreach (Project *p, SessionManager::projects()) {
-        CMakeProject *cmakeProject = qobject_cast<CMakeProject *>(p);
-        if (!cmakeProject)
+    struct ScoredEntry
+    {
+        int score;
+        int index;
+    };
+
+    QVector<TargetEntry> index;
+    QHash<QString, quint64> recentUses;
+    quint64 useCounter;
+    {
+        QMutexLocker locker(&m_mutex);
+        index = m_index;
+        recentUses = m_recentUses;
+        useCounter = m_useCounter;
+    }
+
+    const QString needle = entry.trimmed();
+    QVector<ScoredEntry> scored;
+    for (int i = 0; i < index.size(); ++i) {
+        if (future.isCanceled())
+            return QList<Core::LocatorFilterEntry>();
+
+        const TargetEntry &target = index.at(i);
+        int score = matchScore(target.title, needle);
+        if (score <= 0)
             continue;
-        foreach (const QString &title, cmakeProject->buildTargetTitles()) {
-            if (title.contains(entry)) {
-                Core::LocatorFilterEntry entry(this, title, cmakeProject->projectFilePath().toString());
-                entry.extraInfo = FileUtils::shortNativePath(cmakeProject->projectFilePath());
-                m_result.append(entry);
-            }
+
+        const quint64 lastUse = recentUses.value(recentUseKey(target.projectFilePath, target.title));
+        if (lastUse) {
+            const quint64 age = useCounter - lastUse;
+            score += MAX_RECENT_USE_BONUS - int(qMin<quint64>(age * 10, MAX_RECENT_USE_BONUS));
         }
+        scored.append({ score, i });
     }
-}
 
-QList<Core::LocatorFilterEntry> CMakeLocatorFilter::matchesFor(QFutureInterface<Core::LocatorFilterEntry> &future, const QString &entry)
-{
-    Q_UNUSED(future)
-    Q_UNUSED(entry)
-    return m_result;
+    std::stable_sort(scored.begin(), scored.end(), [&index](const ScoredEntry &a, const ScoredEntry &b) {
+        if (a.score != b.score)
+            return a.score > b.score;
+        return index.at(a.index).title < index.at(b.index).title;
+    });
+
+    QList<Core::LocatorFilterEntry> result;
+    result.reserve(scored.size());
+    foreach (const ScoredEntry &s, scored) {
+        if (future.isCanceled())
+            return QList<Core::LocatorFilterEntry>();
+        const TargetEntry &target = index.at(s.index);
+        Core::LocatorFilterEntry filterEntry(this, target.title, target.projectFilePath);
+        filterEntry.extraInfo = target.extraInfo;
+        result.append(filterEntry);
+    }
+    return result;
 }
 
 void CMakeLocatorFilter::accept(Core::LocatorFilterEntry selection) const
@@ -91,6 +211,12 @@ void CMakeLocatorFilter::accept(Core::LocatorFilterEntry selection) const
     if (!cmakeProject || !cmakeProject->activeTarget() || !cmakeProject->activeTarget()->activeBuildConfiguration())
         return;
 
+    {
+        QMutexLocker locker(&m_mutex);
+        m_recentUses.insert(recentUseKey(selection.internalData.toString(), selection.displayName),
+                            ++m_useCounter);
+    }
+
     // Find the make step
     BuildStepList *buildStepList = cmakeProject->activeTarget()->activeBuildConfiguration()
             ->stepList(ProjectExplorer::Constants::BUILDSTEPS_BUILD);
@@ -117,4 +243,31 @@ void CMakeLocatorFilter::projectListUpdated()
 {
     // Enable the filter if there's at least one CMake project
     setEnabled(Utils::contains(SessionManager::projects(), [](Project *p) { return qobject_cast<CMakeProject *>(p); }));
+    rebuildIndex();
+}
+
+void CMakeLocatorFilter::projectAdded(Project *project)
+{
+    auto cmakeProject = qobject_cast<CMakeProject *>(project);
+    if (!cmakeProject)
+        return;
+    connect(cmakeProject, &CMakeProject::buildTargetsChanged,
+            this, &CMakeLocatorFilter::rebuildIndex, Qt::UniqueConnection);
+}
+
+void CMakeLocatorFilter::rebuildIndex()
+{
+    QVector<TargetEntry> index;
+    foreach (Project *p, SessionManager::projects()) {
+        CMakeProject *cmakeProject = qobject_cast<CMakeProject *>(p);
+        if (!cmakeProject)
+            continue;
+        const QString projectFilePath = cmakeProject->projectFilePath().toString();
+        const QString extraInfo = FileUtils::shortNativePath(cmakeProject->projectFilePath());
+        foreach (const QString &title, cmakeProject->buildTargetTitles())
+            index.append({ title, projectFilePath, extraInfo });
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_index = index;
 }
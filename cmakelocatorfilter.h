@@ -27,6 +27,12 @@
 
 #include <coreplugin/locator/ilocatorfilter.h>
 
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+namespace ProjectExplorer { class Project; }
+
 namespace CMakeProjectManager {
 namespace Internal {
 
@@ -37,16 +43,28 @@ class CMakeLocatorFilter : public Core::ILocatorFilter
 public:
     CMakeLocatorFilter();
 
-    void prepareSearch(const QString &entry) override;
     QList<Core::LocatorFilterEntry> matchesFor(QFutureInterface<Core::LocatorFilterEntry> &future,
                                                const QString &entry) override;
     void accept(Core::LocatorFilterEntry selection) const override;
     void refresh(QFutureInterface<void> &future) override;
 
 private:
+    struct TargetEntry
+    {
+        QString title;
+        QString projectFilePath;
+        QString extraInfo;
+    };
+
     void projectListUpdated();
+    void projectAdded(ProjectExplorer::Project *project);
+    void rebuildIndex();
 
-    QList<Core::LocatorFilterEntry> m_result;
+    // Accessed from the locator worker thread in matchesFor():
+    mutable QMutex m_mutex;
+    QVector<TargetEntry> m_index;
+    mutable QHash<QString, quint64> m_recentUses;
+    mutable quint64 m_useCounter = 0;
 };
 
 } // namespace Internal
@@ -33,27 +33,108 @@ using namespace CMakeProjectManager;
 using namespace Internal;
 using namespace ProjectExplorer;
 
-const char COMMON_ERROR_PATTERN[] = "^CMake Error at (.*):([0-9]*) \\((.*)\\):";
-const char NEXT_SUBERROR_PATTERN[] = "^CMake Error in (.*):";
-const char LOCATION_LINE_PATTERN[] = ":(\\d+):(?:(\\d+))?$";
+const char COMMON_ERROR_PREFIX[] = "CMake Error at ";
+const char NEXT_SUBERROR_PREFIX[] = "CMake Error in ";
+const char CMAKE_ERROR_PREFIX[] = "CMake Error: ";
+const char CODE_LOCATION_SUFFIX[] = "in cmake code at";
 
-CMakeParser::CMakeParser()
+namespace {
+
+bool isAsciiDigit(const QChar c)
+{
+    return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+int rightTrimmedSize(const QString &line)
+{
+    int size = line.size();
+    while (size > 0 && line.at(size - 1).isSpace())
+        --size;
+    return size;
+}
+
+} // namespace
+
+CMakeParser::CMakeParser() = default;
+
+// Matches "CMake Error at <file>:<line> (<command>):", taking the first colon that is
+// followed by the line number and the command.
+bool CMakeParser::parseCommonError(const QStringRef &line)
+{
+    const QLatin1String prefix(COMMON_ERROR_PREFIX);
+    if (!line.startsWith(prefix))
+        return false;
+
+    const int size = line.size();
+    for (int colon = line.indexOf(QLatin1Char(':'), prefix.size()); colon != -1;
+         colon = line.indexOf(QLatin1Char(':'), colon + 1)) {
+        int pos = colon + 1;
+        while (pos < size && isAsciiDigit(line.at(pos)))
+            ++pos;
+        if (pos + 1 >= size || line.at(pos) != QLatin1Char(' ') || line.at(pos + 1) != QLatin1Char('('))
+            continue;
+        if (line.indexOf(QLatin1String("):"), pos + 2) == -1)
+            continue;
+
+        const QString file = line.mid(prefix.size(), colon - prefix.size()).toString();
+        m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(file),
+                          line.mid(colon + 1, pos - colon - 1).toInt(),
+                          Constants::TASK_CATEGORY_BUILDSYSTEM);
+        m_lines = 1;
+        return true;
+    }
+    return false;
+}
+
+// Matches "CMake Error in <file>:".
+bool CMakeParser::parseNextSubError(const QStringRef &line)
+{
+    const QLatin1String prefix(NEXT_SUBERROR_PREFIX);
+    if (!line.startsWith(prefix))
+        return false;
+
+    const int colon = line.indexOf(QLatin1Char(':'), prefix.size());
+    if (colon == -1)
+        return false;
+
+    const QString file = line.mid(prefix.size(), colon - prefix.size()).toString();
+    m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(file), -1,
+                      Constants::TASK_CATEGORY_BUILDSYSTEM);
+    m_lines = 1;
+    return true;
+}
+
+// Splits "<file>:<line>:[<column>]", scanning from the end of the line.
+void CMakeParser::parseLocationLine(const QStringRef &line)
 {
-    m_commonError.setPattern(QLatin1String(COMMON_ERROR_PATTERN));
-    m_commonError.setMinimal(true);
-    QTC_CHECK(m_commonError.isValid());
+    int pos = line.size();
+    while (pos > 0 && isAsciiDigit(line.at(pos - 1))) // optional column
+        --pos;
 
-    m_nextSubError.setPattern(QLatin1String(NEXT_SUBERROR_PATTERN));
-    m_nextSubError.setMinimal(true);
-    QTC_CHECK(m_nextSubError.isValid());
+    int lineStart = -1;
+    int lineEnd = -1;
+    if (pos > 0 && line.at(pos - 1) == QLatin1Char(':')) {
+        lineEnd = pos - 1;
+        lineStart = lineEnd;
+        while (lineStart > 0 && isAsciiDigit(line.at(lineStart - 1)))
+            --lineStart;
+    }
 
-    m_locationLine.setPattern(QLatin1String(LOCATION_LINE_PATTERN));
-    QTC_CHECK(m_locationLine.isValid());
+    const bool matched = lineStart > 0 && lineStart < lineEnd
+            && line.at(lineStart - 1) == QLatin1Char(':');
+    QTC_CHECK(matched);
+    if (matched) {
+        m_lastTask.file = Utils::FileName::fromUserInput(line.left(lineStart - 1).toString());
+        m_lastTask.line = line.mid(lineStart, lineEnd - lineStart).toInt();
+    } else {
+        m_lastTask.file = Utils::FileName::fromUserInput(line.toString());
+        m_lastTask.line = 0;
+    }
 }
 
 void CMakeParser::stdError(const QString &line)
 {
-    QString trimmedLine = rightTrimmed(line);
+    const QStringRef trimmedLine = line.leftRef(rightTrimmedSize(line));
 
     switch (m_expectTripleLineErrorData) {
     case NONE:
@@ -67,15 +148,7 @@ void CMakeParser::stdError(const QString &line)
         if (m_skippedFirstEmptyLine)
             m_skippedFirstEmptyLine = false;
 
-        if (m_commonError.indexIn(trimmedLine) != -1) {
-            m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(m_commonError.cap(1)),
-                              m_commonError.cap(2).toInt(), Constants::TASK_CATEGORY_BUILDSYSTEM);
-            m_lines = 1;
-            return;
-        } else if (m_nextSubError.indexIn(trimmedLine) != -1) {
-            m_lastTask = Task(Task::Error, QString(), Utils::FileName::fromUserInput(m_nextSubError.cap(1)), -1,
-                              Constants::TASK_CATEGORY_BUILDSYSTEM);
-            m_lines = 1;
+        if (parseCommonError(trimmedLine) || parseNextSubError(trimmedLine)) {
             return;
         } else if (trimmedLine.startsWith(QLatin1String("  ")) && !m_lastTask.isNull()) {
             if (!m_lastTask.description.isEmpty())
@@ -83,14 +156,14 @@ void CMakeParser::stdError(const QString &line)
             m_lastTask.description.append(trimmedLine.trimmed());
             ++m_lines;
             return;
-        } else if (trimmedLine.endsWith(QLatin1String("in cmake code at"))) {
+        } else if (trimmedLine.endsWith(QLatin1String(CODE_LOCATION_SUFFIX))) {
             m_expectTripleLineErrorData = LINE_LOCATION;
             doFlush();
-            m_lastTask = Task(trimmedLine.contains(QLatin1String("Error")) ? Task::Error : Task::Warning,
+            m_lastTask = Task(trimmedLine.indexOf(QLatin1String("Error")) != -1 ? Task::Error : Task::Warning,
                               QString(), Utils::FileName(), -1, Constants::TASK_CATEGORY_BUILDSYSTEM);
             return;
-        } else if (trimmedLine.startsWith("CMake Error: ")) {
-            m_lastTask = Task(Task::Error, trimmedLine.mid(13),
+        } else if (trimmedLine.startsWith(QLatin1String(CMAKE_ERROR_PREFIX))) {
+            m_lastTask = Task(Task::Error, trimmedLine.mid(int(sizeof(CMAKE_ERROR_PREFIX)) - 1).toString(),
                               Utils::FileName(), -1, Constants::TASK_CATEGORY_BUILDSYSTEM);
             m_lines = 1;
             return;
@@ -98,16 +171,11 @@ void CMakeParser::stdError(const QString &line)
         IOutputParser::stdError(line);
         return;
     case LINE_LOCATION:
-        {
-            QRegularExpressionMatch m = m_locationLine.match(trimmedLine);
-            QTC_CHECK(m.hasMatch());
-            m_lastTask.file = Utils::FileName::fromUserInput(trimmedLine.mid(0, m.capturedStart()));
-            m_lastTask.line = m.captured(1).toInt();
-            m_expectTripleLineErrorData = LINE_DESCRIPTION;
-        }
+        parseLocationLine(trimmedLine);
+        m_expectTripleLineErrorData = LINE_DESCRIPTION;
         return;
     case LINE_DESCRIPTION:
-        m_lastTask.description = trimmedLine;
+        m_lastTask.description = trimmedLine.toString();
         if (trimmedLine.endsWith(QLatin1Char('\"')))
             m_expectTripleLineErrorData = LINE_DESCRIPTION2;
         else {
@@ -281,4 +349,49 @@ void CMakeProjectPlugin::testCMakeParser()
                           outputLines);
 }
 
+void CMakeProjectPlugin::testCMakeParserBenchmark()
+{
+    const QStringList block = {
+        QLatin1String("-- Configuring incomplete, errors occurred!"),
+        QLatin1String("CMake Error at src/1/app/CMakeLists.txt:70 (add_custom_target):"),
+        QLatin1String("  Cannot find source file:"),
+        QString(),
+        QLatin1String("    unknownFile.qml"),
+        QString(),
+        QLatin1String("  Tried extensions .c .C .c++ .cc .cpp .cxx .m .M .mm .h .hh .h++ .hm .hpp"),
+        QLatin1String("  .hxx .in .txx"),
+        QString(),
+        QString(),
+        QLatin1String("CMake Error in src/1/app/CMakeLists.txt:"),
+        QLatin1String("  Cannot find source file:"),
+        QString(),
+        QLatin1String("    CMakeLists.txt2"),
+        QString(),
+        QString(),
+        QLatin1String("Syntax Warning in cmake code at"),
+        QLatin1String("/test/path/CMakeLists.txt:9:15"),
+        QLatin1String("Argument not separated from preceding token by whitespace."),
+        QLatin1String("CMake Error: Error required internal CMake variable not set."),
+        QLatin1String("Missing variable is:"),
+        QLatin1String("CMAKE_MAKE_PROGRAM")
+    };
+
+    // Synthetic log of about 4 MiB:
+    QStringList lines;
+    int size = 0;
+    while (size < 4 * 1024 * 1024) {
+        foreach (const QString &line, block) {
+            lines.append(line);
+            size += line.size() + 1;
+        }
+    }
+
+    QBENCHMARK {
+        CMakeParser parser;
+        foreach (const QString &line, lines)
+            parser.stdError(line);
+        parser.flush();
+    }
+}
+
 #endif
@@ -28,8 +28,6 @@
 #include <projectexplorer/ioutputparser.h>
 #include <projectexplorer/task.h>
 
-#include <QRegularExpression>
-
 namespace CMakeProjectManager {
 namespace Internal {
 
@@ -49,10 +47,11 @@ private:
 
     TripleLineError m_expectTripleLineErrorData = NONE;
 
+    bool parseCommonError(const QStringRef &line);
+    bool parseNextSubError(const QStringRef &line);
+    void parseLocationLine(const QStringRef &line);
+
     ProjectExplorer::Task m_lastTask;
-    QRegExp m_commonError;
-    QRegExp m_nextSubError;
-    QRegularExpression m_locationLine;
     bool m_skippedFirstEmptyLine = false;
     int m_lines = 0;
 };
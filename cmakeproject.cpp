@@ -30,6 +30,7 @@
 #include "cmakeprojectconstants.h"
 #include "cmakeprojectnodes.h"
 #include "cmakerunconfiguration.h"
+#include "generatedfilesindex.h"
 #include "cmakeprojectmanager.h"
 #include "treebuilder.h"
 
@@ -66,6 +67,8 @@ using namespace Utils;
 namespace CMakeProjectManager {
 
 const int MIN_TIME_BETWEEN_TREE_SCANS = 4500;
+// Build configurations (including the active one) that keep their parsed data:
+const int MAX_RETAINED_BUILD_CONFIGURATIONS = 3;
 
 using namespace Internal;
 
@@ -108,6 +111,9 @@ CMakeProject::~CMakeProject()
     setRootProjectNode(nullptr);
     m_codeModelFuture.cancel();
     qDeleteAll(m_extraCompilers);
+
+    m_treeFiles.clear();
+    FileNodeInfo::releaseUnusedDirectories();
 }
 
 void CMakeProject::updateProjectData()
@@ -128,31 +134,66 @@ void CMakeProject::updateProjectData()
         return;
     }
 
+    refreshProjectData(cmakeBc);
+}
+
+void CMakeProject::refreshProjectData(CMakeBuildConfiguration *cmakeBc)
+{
     QTC_ASSERT(cmakeBc, return);
+    Target *t = cmakeBc->target();
 
     // Initially, populate project tree by the CMake parsing data if it already done to allow user
     // begin work with project and update project tree with file system files when scanning completes.
     // Do not use file system data as a initial project tree: we have no information about targets,
     // flags and so on from build system, so parsing will be ugly and navigation too.
-    const auto cacheEmpty = m_sourceFilesCache.empty() && m_generatedFilesCache.empty();
+    const auto cacheEmpty = m_allFilesCache.empty();
     if ((m_treeBuilder->isScanning() || cmakeBc->isParsing()) &&
         (cmakeBc->isParsing() || !cacheEmpty))
         return;
 
-    Kit *k = t->kit();
-
     cmakeBc->generateProjectTree(static_cast<CMakeProjectNode *>(rootProjectNode()), m_treeFiles);
 
     updateApplicationAndDeploymentTargets();
     updateTargetRunConfigurations(t);
+    emit buildTargetsChanged();
+
+    updateQmlJSCodeModel();
+
+    emit displayNameChanged();
+    emit fileListChanged();
+
+    emit cmakeBc->emitBuildTypeChanged();
+
+    // Otherwise updateCodeModelData() follows once the build configuration has read it:
+    if (cmakeBc->hasCodeModelData())
+        refreshCodeModel(cmakeBc);
+}
+
+void CMakeProject::updateCodeModelData()
+{
+    auto cmakeBc = qobject_cast<CMakeBuildConfiguration *>(sender());
+    QTC_ASSERT(cmakeBc, return);
+
+    Target *t = activeTarget();
+    if (!t || t->activeBuildConfiguration() != cmakeBc || cmakeBc->isParsing())
+        return;
+    // refreshProjectData() will pick the data up when the tree is populated:
+    if (m_treeBuilder->isScanning() && m_allFilesCache.empty())
+        return;
+
+    refreshCodeModel(cmakeBc);
+}
+
+void CMakeProject::refreshCodeModel(CMakeBuildConfiguration *cmakeBc)
+{
+    QTC_ASSERT(cmakeBc, return);
+    Kit *k = cmakeBc->target()->kit();
 
     createGeneratedCodeModelSupport();
 
     ToolChain *tc = ToolChainKitInformation::toolChain(k, ToolChain::Language::Cxx);
-    if (!tc) {
-        emit fileListChanged();
+    if (!tc)
         return;
-    }
 
     CppTools::CppModelManager *modelmanager = CppTools::CppModelManager::instance();
     CppTools::ProjectInfo pinfo(this);
@@ -168,20 +209,18 @@ void CMakeProject::updateProjectData()
 
     ppBuilder.setQtVersion(activeQtVersion);
 
-    const QSet<Core::Id> languages = cmakeBc->updateCodeModel(ppBuilder);
+    bool codeModelChanged = true;
+    const QSet<Core::Id> languages = cmakeBc->updateCodeModel(pinfo, ppBuilder, &codeModelChanged);
     for (const auto &lid : languages)
         setProjectLanguage(lid, true);
 
-    m_codeModelFuture.cancel();
-    pinfo.finish();
-    m_codeModelFuture = modelmanager->updateProjectInfo(pinfo);
-
-    updateQmlJSCodeModel();
-
-    emit displayNameChanged();
-    emit fileListChanged();
-
-    emit cmakeBc->emitBuildTypeChanged();
+    // Nothing to reindex if the code model already has exactly these parts:
+    if (codeModelChanged || m_codeModelBuildConfiguration != cmakeBc) {
+        m_codeModelFuture.cancel();
+        pinfo.finish();
+        m_codeModelFuture = modelmanager->updateProjectInfo(pinfo);
+        m_codeModelBuildConfiguration = cmakeBc;
+    }
 }
 
 void CMakeProject::updateQmlJSCodeModel()
@@ -270,6 +309,8 @@ void CMakeProject::handleScanningFinished()
     m_treePaths = m_treeBuilder->paths();
     m_treeFiles = m_treeBuilder->files();
     m_treeBuilder->clear();
+    FileNodeInfo::releaseUnusedDirectories();
+    clearCMakeListsDirectories();
 
 #ifdef USE_TREE_WATCHER
     for (auto &path : m_treePaths)
@@ -330,8 +371,8 @@ FileNameList CMakeProject::directoryList(const QList<FileNodeInfo> &paths) const
 {
     QList<FileName> dirs;
     for (const auto& path : paths) {
-        auto fi = path.filePath.toFileInfo();
-        auto insertPath = path.filePath;
+        auto insertPath = path.filePath();
+        auto fi = insertPath.toFileInfo();
 
         if (!fi.isDir()) {
             insertPath = FileName::fromString(fi.absolutePath());
@@ -380,8 +421,17 @@ QSet<FileName> CMakeProject::directoryEntries(const FileName &directory) const
         }
     };
 
-    for (const auto& fn : m_treeFiles)
-        processFileName(fn.filePath);
+    const QString directoryPath = directory.toString();
+    const QChar *lastDirectory = nullptr;
+    for (const auto& fn : m_treeFiles) {
+        if (fn.directory == directoryPath) {
+            result.insert(Utils::FileName::fromString(fn.fileName));
+        } else if (fn.directory.constData() != lastDirectory) {
+            // Entries are sorted, so all files of a directory give the same result:
+            lastDirectory = fn.directory.constData();
+            processFileName(Utils::FileName::fromString(fn.directory));
+        }
+    }
     for (const auto& fn : m_treePaths)
         processFileName(fn);
 
@@ -404,6 +454,7 @@ void CMakeProject::addFilesCommon(const QStringList& filePaths)
     std::inplace_merge(m_treeFiles.begin(),
                        m_treeFiles.begin() + oldSize,
                        m_treeFiles.end());
+    clearCMakeListsDirectories();
 
     auto dirs = directoryList(paths);
 
@@ -439,6 +490,7 @@ void CMakeProject::eraseFilesCommon(const QStringList &filePaths)
                         std::back_inserter(filtered));
 
     m_treeFiles = filtered;
+    clearCMakeListsDirectories();
 
     // Process paths
     auto dirs = directoryList(paths);
@@ -511,32 +563,68 @@ QString CMakeProject::displayName() const
 
 QStringList CMakeProject::files(FilesMode fileMode) const
 {
-    if (m_generatedFilesCache.empty() && m_sourceFilesCache.empty())
+    if (m_filesGeneration == 0)
         updateFilesCache(rootProjectNode()->recursiveFileNodes());
 
+    // All lists are precomputed, so this only hands out shallow copies:
     switch (fileMode) {
         case Project::GeneratedFiles:
             return m_generatedFilesCache;
         case Project::SourceFiles:
             return m_sourceFilesCache;
         case Project::AllFiles:
-            return m_sourceFilesCache + m_generatedFilesCache;
+            return m_allFilesCache;
     }
     return QStringList();
 }
 
+quint64 CMakeProject::filesGeneration() const
+{
+    return m_filesGeneration;
+}
+
+void CMakeProject::updateFilesCache(const QList<FileNodeInfo> &files) const
+{
+    QStringList sources;
+    QStringList generated;
+    sources.reserve(files.size());
+    for (const FileNodeInfo &info : files) {
+        if (info.fileType == UnknownFileType)
+            continue;
+        if (info.generated)
+            generated.push_back(info.filePath().toString());
+        else
+            sources.push_back(info.filePath().toString());
+    }
+    setFilesCache(sources, generated);
+}
+
 void CMakeProject::updateFilesCache(const QList<FileNode *> &nodes) const
 {
-    m_generatedFilesCache.clear();
-    m_sourceFilesCache.clear();
+    QStringList sources;
+    QStringList generated;
+    sources.reserve(nodes.size());
     for (auto &node : nodes) {
         if (node->fileType() == UnknownFileType)
             continue;
         if (node->isGenerated())
-            m_generatedFilesCache.push_back(node->filePath().toString());
+            generated.push_back(node->filePath().toString());
         else
-            m_sourceFilesCache.push_back(node->filePath().toString());
+            sources.push_back(node->filePath().toString());
     }
+    setFilesCache(sources, generated);
+}
+
+void CMakeProject::setFilesCache(const QStringList &sources, const QStringList &generated) const
+{
+    // Keep the lists handed out so far (and the generation) if nothing changed:
+    if (m_filesGeneration != 0 && sources == m_sourceFilesCache && generated == m_generatedFilesCache)
+        return;
+
+    m_sourceFilesCache = sources;
+    m_generatedFilesCache = generated;
+    m_allFilesCache = sources + generated;
+    ++m_filesGeneration;
 }
 
 Project::RestoreResult CMakeProject::fromMap(const QVariantMap &map, QString *errorMessage)
@@ -584,16 +672,29 @@ void CMakeProject::handleActiveBuildConfigurationChanged()
         return;
     auto activeBc = qobject_cast<CMakeBuildConfiguration *>(activeTarget()->activeBuildConfiguration());
 
+    // The most recently used configurations keep their data, so switching back is instant:
+    m_recentBuildConfigurations.removeAll(nullptr);
+    if (activeBc) {
+        m_recentBuildConfigurations.removeAll(activeBc);
+        m_recentBuildConfigurations.prepend(activeBc);
+    }
+    while (m_recentBuildConfigurations.size() > MAX_RETAINED_BUILD_CONFIGURATIONS)
+        m_recentBuildConfigurations.removeLast();
+
     foreach (Target *t, targets()) {
         foreach (BuildConfiguration *bc, t->buildConfigurations()) {
             auto i = qobject_cast<CMakeBuildConfiguration *>(bc);
             QTC_ASSERT(i, continue);
-            if (i == activeBc)
-                i->maybeForceReparse();
-            else
+            if (i != activeBc && i->hasData() && !m_recentBuildConfigurations.contains(i))
                 i->resetData();
         }
     }
+
+    if (activeBc) {
+        if (activeBc->hasData() && !activeBc->isParsing())
+            refreshProjectData(activeBc);
+        activeBc->maybeForceReparse();
+    }
 }
 
 void CMakeProject::handleParsingStarted()
@@ -614,19 +715,17 @@ QStringList CMakeProject::filesGeneratedFrom(const QString &sourceFile) const
 {
     if (!activeTarget())
         return QStringList();
+
+    // Prefer what the build system knows over guessing:
+    auto cmakeBc = qobject_cast<CMakeBuildConfiguration *>(activeTarget()->activeBuildConfiguration());
+    const GeneratedFilesIndex *index = cmakeBc ? cmakeBc->generatedFiles() : nullptr;
+    const FileName source = FileName::fromString(sourceFile);
+    if (index && index->contains(source))
+        return transform(index->outputsFor(source), &FileName::toString);
+
     QFileInfo fi(sourceFile);
     FileName project = projectDirectory();
-    FileName baseDirectory = FileName::fromString(fi.absolutePath());
-
-    while (baseDirectory.isChildOf(project)) {
-        FileName cmakeListsTxt = baseDirectory;
-        cmakeListsTxt.appendPath("CMakeLists.txt");
-        if (cmakeListsTxt.exists())
-            break;
-        QDir dir(baseDirectory.toString());
-        dir.cdUp();
-        baseDirectory = FileName::fromString(dir.absolutePath());
-    }
+    const FileName baseDirectory = cmakeListsDirectory(FileName::fromString(fi.absolutePath()));
 
     QDir srcDirRoot = QDir(project.toString());
     QString relativePath = srcDirRoot.relativeFilePath(baseDirectory.toString());
@@ -649,6 +748,46 @@ QStringList CMakeProject::filesGeneratedFrom(const QString &sourceFile) const
     }
 }
 
+FileName CMakeProject::cmakeListsDirectory(const FileName &directory) const
+{
+    auto it = m_cmakeListsDirectories.constFind(directory);
+    if (it != m_cmakeListsDirectories.constEnd())
+        return it.value();
+
+    // Known CMakeLists.txt files are taken from the tree scan, if there is one:
+    if (m_cmakeListsFiles.isEmpty()) {
+        for (const FileNodeInfo &info : m_treeFiles) {
+            if (info.fileName == QLatin1String("CMakeLists.txt"))
+                m_cmakeListsFiles.insert(info.filePath());
+        }
+    }
+    const bool useTree = !m_cmakeListsFiles.isEmpty();
+
+    const FileName project = projectDirectory();
+    FileName baseDirectory = directory;
+    while (baseDirectory.isChildOf(project)) {
+        auto cached = m_cmakeListsDirectories.constFind(baseDirectory);
+        if (cached != m_cmakeListsDirectories.constEnd()) {
+            baseDirectory = cached.value();
+            break;
+        }
+        FileName cmakeListsTxt = baseDirectory;
+        cmakeListsTxt.appendPath("CMakeLists.txt");
+        if (useTree ? m_cmakeListsFiles.contains(cmakeListsTxt) : cmakeListsTxt.exists())
+            break;
+        baseDirectory = baseDirectory.parentDir();
+    }
+
+    m_cmakeListsDirectories.insert(directory, baseDirectory);
+    return baseDirectory;
+}
+
+void CMakeProject::clearCMakeListsDirectories()
+{
+    m_cmakeListsDirectories.clear();
+    m_cmakeListsFiles.clear();
+}
+
 void CMakeProject::updateTargetRunConfigurations(Target *t)
 {
     // *Update* existing runconfigurations (no need to update new ones!):
@@ -736,33 +875,59 @@ void CMakeProject::updateApplicationAndDeploymentTargets()
 
 void CMakeProject::createGeneratedCodeModelSupport()
 {
-    qDeleteAll(m_extraCompilers);
+    QHash<QString, QList<ExtraCompilerFactory *>> factoriesBySuffix;
+    foreach (ExtraCompilerFactory *factory, ExtraCompilerFactory::extraCompilerFactories())
+        factoriesBySuffix[factory->sourceTag()].append(factory);
+
+    // Existing extra compilers are kept if factory, source and targets did not change:
+    QHash<FileName, QList<ExtraCompiler *>> oldCompilers;
+    foreach (ExtraCompiler *compiler, m_extraCompilers)
+        oldCompilers[compiler->source()].append(compiler);
+    QHash<ExtraCompiler *, ExtraCompilerFactory *> oldFactories;
+    oldFactories.swap(m_extraCompilerFactories);
     m_extraCompilers.clear();
-    QList<ExtraCompilerFactory *> factories =
-            ExtraCompilerFactory::extraCompilerFactories();
 
     // Find all files generated by any of the extra compilers, in a rather crude way.
     foreach (const QString &file, files(SourceFiles)) {
-        foreach (ExtraCompilerFactory *factory, factories) {
-            if (file.endsWith('.' + factory->sourceTag())) {
-                QStringList generated = filesGeneratedFrom(file);
-                if (!generated.isEmpty()) {
-                    const FileNameList fileNames = transform(generated,
-                                                             [](const QString &s) {
-                        return FileName::fromString(s);
-                    });
-                    m_extraCompilers.append(factory->create(this, FileName::fromString(file),
-                                                            fileNames));
-                }
+        const int dot = file.lastIndexOf('.');
+        if (dot < 0)
+            continue;
+        auto factories = factoriesBySuffix.constFind(file.mid(dot + 1));
+        if (factories == factoriesBySuffix.constEnd())
+            continue;
+
+        const QStringList generated = filesGeneratedFrom(file);
+        if (generated.isEmpty())
+            continue;
+        const FileName source = FileName::fromString(file);
+        const FileNameList fileNames = transform(generated, [](const QString &s) {
+            return FileName::fromString(s);
+        });
+
+        QList<ExtraCompiler *> &candidates = oldCompilers[source];
+        foreach (ExtraCompilerFactory *factory, factories.value()) {
+            auto reusable = std::find_if(candidates.begin(), candidates.end(),
+                                         [&](ExtraCompiler *compiler) {
+                return oldFactories.value(compiler) == factory && compiler->targets() == fileNames;
+            });
+            ExtraCompiler *compiler = nullptr;
+            if (reusable != candidates.end()) {
+                compiler = *reusable;
+                candidates.erase(reusable);
+            } else {
+                compiler = factory->create(this, source, fileNames);
             }
+            m_extraCompilers.append(compiler);
+            m_extraCompilerFactories.insert(compiler, factory);
         }
     }
 
+    foreach (const QList<ExtraCompiler *> &unused, oldCompilers)
+        qDeleteAll(unused);
+
     CppTools::GeneratedCodeModelSupport::update(m_extraCompilers);
 }
 
-
-
 void CMakeBuildTarget::clear()
 {
     executable.clear();
@@ -780,25 +945,38 @@ void CMakeBuildTarget::clear()
 bool CMakeProject::addFiles(const QStringList &filePaths)
 {
     addFilesCommon(filePaths);
-    // If globbing is used, watched does not know about new files, so force rebuilding
-    runCMake();
+    updateAfterFileChanges(filePaths);
     return true;
 }
 
 bool CMakeProject::eraseFiles(const QStringList &filePaths)
 {
     eraseFilesCommon(filePaths);
-    // FIXME force only when really needed
-    runCMake();
+    updateAfterFileChanges(filePaths);
     return true;
 }
 
 bool CMakeProject::renameFile(const QString &filePath, const QString &newFilePath)
 {
     renameFileCommon(filePath, newFilePath);
-    // FIXME force only when really needed
-    runCMake();
+    updateAfterFileChanges({ filePath, newFilePath });
     return true;
 }
 
+void CMakeProject::updateAfterFileChanges(const QStringList &filePaths)
+{
+    CMakeBuildConfiguration *bc = nullptr;
+    if (activeTarget())
+        bc = qobject_cast<CMakeBuildConfiguration *>(activeTarget()->activeBuildConfiguration());
+    if (!bc)
+        return;
+
+    // Only configure if cmake might see the change, e.g. through globbing. Otherwise the
+    // tree files were already updated, so just refresh tree and code model:
+    if (bc->isConfigureNeededFor(filePaths))
+        bc->runCMake();
+    else
+        refreshProjectData(bc);
+}
+
 } // namespace CMakeProjectManager
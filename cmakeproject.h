@@ -34,6 +34,8 @@
 #include <utils/fileutils.h>
 
 #include <QFuture>
+#include <QPointer>
+#include <QHash>
 #include <QFileSystemWatcher>
 #include <QTimer>
 #include <QElapsedTimer>
@@ -93,7 +95,10 @@ public:
     QString displayName() const final;
 
     QStringList files(FilesMode fileMode) const final;
+    // Changes whenever the lists returned by files() change:
+    quint64 filesGeneration() const;
     void updateFilesCache(const QList<ProjectExplorer::FileNode*> &nodes) const;
+    void updateFilesCache(const QList<Internal::FileNodeInfo> &files) const;
     QStringList buildTargetTitles(bool runnable = false) const;
     bool hasBuildTarget(const QString &title) const;
 
@@ -115,6 +120,8 @@ public:
 signals:
     /// emitted when cmake is running:
     void parsingStarted();
+    /// emitted when the build targets were updated from new cmake data:
+    void buildTargetsChanged();
 
 protected:
     RestoreResult fromMap(const QVariantMap &map, QString *errorMessage) final;
@@ -131,27 +138,42 @@ private:
     void eraseFilesCommon(const QStringList &filePaths);
     void renameFileCommon(const QString &filePath, const QString &newFilePath);
     void scheduleScanProjectTree();
+    void setFilesCache(const QStringList &sources, const QStringList &generated) const;
 
     void handleActiveTargetChanged();
     void handleActiveBuildConfigurationChanged();
     void handleParsingStarted();
     void updateProjectData();
+    void refreshProjectData(Internal::CMakeBuildConfiguration *cmakeBc);
+    void updateCodeModelData();
+    void refreshCodeModel(Internal::CMakeBuildConfiguration *cmakeBc);
+    void updateAfterFileChanges(const QStringList &filePaths);
     void updateQmlJSCodeModel();
 
     void createGeneratedCodeModelSupport();
     QStringList filesGeneratedFrom(const QString &sourceFile) const final;
+    Utils::FileName cmakeListsDirectory(const Utils::FileName &directory) const;
+    void clearCMakeListsDirectories();
     void updateTargetRunConfigurations(ProjectExplorer::Target *t);
     void updateApplicationAndDeploymentTargets();
 
     ProjectExplorer::Target *m_connectedTarget = nullptr;
+    QList<QPointer<Internal::CMakeBuildConfiguration>> m_recentBuildConfigurations;
 
     // TODO probably need a CMake specific node structure
     QList<CMakeBuildTarget> m_buildTargets;
     QFuture<void> m_codeModelFuture;
+    QPointer<Internal::CMakeBuildConfiguration> m_codeModelBuildConfiguration;
     QList<ProjectExplorer::ExtraCompiler *> m_extraCompilers;
+    QHash<ProjectExplorer::ExtraCompiler *, ProjectExplorer::ExtraCompilerFactory *> m_extraCompilerFactories;
+    // Directory to the nearest directory with a CMakeLists.txt, see filesGeneratedFrom():
+    mutable QHash<Utils::FileName, Utils::FileName> m_cmakeListsDirectories;
+    mutable QSet<Utils::FileName> m_cmakeListsFiles;
 
     mutable QStringList m_sourceFilesCache;
     mutable QStringList m_generatedFilesCache;
+    mutable QStringList m_allFilesCache;
+    mutable quint64 m_filesGeneration = 0;
 
     std::unique_ptr<Internal::TreeBuilder> m_treeBuilder;
     QList<Internal::FileNodeInfo> m_treeFiles;
@@ -40,6 +40,7 @@ const char CLEARCMAKECACHE[] = "CMakeProject.ClearCache";
 const char RUNCMAKECONTEXTMENU[] = "CMakeProject.RunCMakeContextMenu";
 const char RESCANPROJECT[] = "CMakeProject.RescanProject";
 const char RESCANPROJECTCONTEXTMENU[] = "CMakeProject.RescanProjectContextMenu";
+const char CONFIGUREALL[] = "CMakeProject.ConfigureAll";
 
 // Project
 const char CMAKEPROJECT_ID[] = "CMakeProjectManager.CMakeProject";
@@ -31,6 +31,7 @@
 #include "cmakeproject.h"
 #include "cmakesettingspage.h"
 #include "cmaketoolmanager.h"
+#include "configurescheduler.h"
 
 #include <coreplugin/icore.h>
 #include <coreplugin/actionmanager/actionmanager.h>
@@ -57,6 +58,7 @@ CMakeManager::CMakeManager() :
     m_runCMakeAction(new QAction(QIcon(), tr("Run CMake"), this)),
     m_clearCMakeCacheAction(new QAction(QIcon(), tr("Clear CMake Configuration"), this)),
     m_runCMakeActionContextMenu(new QAction(QIcon(), tr("Run CMake"), this)),
+    m_configureAllAction(new QAction(QIcon(), tr("Run CMake for All Build Configurations"), this)),
     m_rescanProjectAction(new QAction(QIcon(), tr("Rescan project"), this)),
     m_rescanProjectContextMenuAction(new QAction(QIcon(), tr("Rescan project"),this))
 {
@@ -86,6 +88,14 @@ CMakeManager::CMakeManager() :
         clearCMakeCache(SessionManager::startupProject());
     });
 
+    command = Core::ActionManager::registerAction(m_configureAllAction,
+                                                  Constants::CONFIGUREALL, globalContext);
+    command->setAttribute(Core::Command::CA_Hide);
+    mbuild->addAction(command, ProjectExplorer::Constants::G_BUILD_DEPLOY);
+    connect(m_configureAllAction, &QAction::triggered, [this]() {
+        configureAll(SessionManager::startupProject());
+    });
+
     command = Core::ActionManager::registerAction(m_runCMakeActionContextMenu,
                                                   Constants::RUNCMAKECONTEXTMENU, projectContext);
     command->setAttribute(Core::Command::CA_Hide);
@@ -125,6 +135,7 @@ void CMakeManager::updateCmakeActions()
     auto project = qobject_cast<CMakeProject *>(SessionManager::startupProject());
     const bool visible = project && !BuildManager::isBuilding(project);
     m_runCMakeAction->setVisible(visible);
+    m_configureAllAction->setVisible(visible);
     m_clearCMakeCacheAction->setVisible(visible);
     m_rescanProjectAction->setVisible(visible);
 }
@@ -154,6 +165,25 @@ void CMakeManager::runCMake(Project *project)
     cmakeProject->runCMake();
 }
 
+void CMakeManager::configureAll(Project *project)
+{
+    if (!qobject_cast<CMakeProject *>(project))
+        return;
+
+    if (!ProjectExplorerPlugin::saveModifiedFiles())
+        return;
+
+    // All kits and build configurations, the scheduler limits how many run at once:
+    QList<CMakeBuildConfiguration *> buildConfigurations;
+    foreach (Target *t, project->targets()) {
+        foreach (BuildConfiguration *bc, t->buildConfigurations()) {
+            if (auto cmakeBc = qobject_cast<CMakeBuildConfiguration *>(bc))
+                buildConfigurations.append(cmakeBc);
+        }
+    }
+    ConfigureScheduler::instance()->configure(buildConfigurations);
+}
+
 void CMakeManager::rescanProject(Project *project)
 {
     if (!project)
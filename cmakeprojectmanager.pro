@@ -40,6 +40,14 @@ HEADERS = builddirmanager.h \
     cmakeautocompleter.h \
     configmodel.h \
     configmodelitemdelegate.h \
+    configmodelfilter.h \
+    reparsescheduler.h \
+    cmakeinputledger.h \
+    compilecommands.h \
+    configurescheduler.h \
+    generatedfilesindex.h \
+    cmaketrace.h \
+    cmakebenchmarks.h \
     cmaketoolchaininfo.h \
     treebuilder.h
 
@@ -69,6 +77,14 @@ SOURCES = builddirmanager.cpp \
     cmakeautocompleter.cpp \
     configmodel.cpp \
     configmodelitemdelegate.cpp \
+    configmodelfilter.cpp \
+    reparsescheduler.cpp \
+    cmakeinputledger.cpp \
+    compilecommands.cpp \
+    configurescheduler.cpp \
+    generatedfilesindex.cpp \
+    cmaketrace.cpp \
+    cmakebenchmarks.cpp \
     cmaketoolchaininfo.cpp \
     treebuilder.cpp
 
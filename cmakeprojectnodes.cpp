@@ -25,9 +25,152 @@
 
 #include "cmakeprojectnodes.h"
 
+#include <utils/hostosinfo.h>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+
 using namespace CMakeProjectManager;
 using namespace CMakeProjectManager::Internal;
 
+namespace {
+
+struct DirectoryTable
+{
+    QMutex mutex;
+    QSet<QString> directories;
+};
+
+Q_GLOBAL_STATIC(DirectoryTable, directoryTable)
+
+// A path as directory + '/' + file name, or as plain string if there is no file name:
+class PathCursor
+{
+public:
+    PathCursor(const QString &directory, const QString *fileName) :
+        m_directory(directory), m_fileName(fileName)
+    { }
+
+    int size() const
+    {
+        return m_fileName ? m_directory.size() + 1 + m_fileName->size() : m_directory.size();
+    }
+
+    ushort at(int i) const
+    {
+        if (i < m_directory.size())
+            return m_directory.at(i).unicode();
+        if (i == m_directory.size())
+            return '/';
+        return m_fileName->at(i - m_directory.size() - 1).unicode();
+    }
+
+private:
+    const QString &m_directory;
+    const QString *m_fileName;
+};
+
+PathCursor cursor(const FileNodeInfo &info)
+{
+    if (info.directory.isNull())
+        return PathCursor(info.fileName, nullptr);
+    return PathCursor(info.directory, &info.fileName);
+}
+
+int comparePaths(const PathCursor &lhs, const PathCursor &rhs)
+{
+    const bool caseSensitive
+            = Utils::HostOsInfo::fileNameCaseSensitivity() == Qt::CaseSensitive;
+    const int size = qMin(lhs.size(), rhs.size());
+    for (int i = 0; i < size; ++i) {
+        ushort l = lhs.at(i);
+        ushort r = rhs.at(i);
+        if (l == r)
+            continue;
+        if (!caseSensitive) {
+            l = QChar::toCaseFolded(l);
+            r = QChar::toCaseFolded(r);
+            if (l == r)
+                continue;
+        }
+        return l < r ? -1 : 1;
+    }
+    return lhs.size() - rhs.size();
+}
+
+} // namespace
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+FileNodeInfo::FileNodeInfo(const Utils::FileName &filePath, const ProjectExplorer::FileType fileType,
+                           bool generated, const QString &sharedDirectory) :
+    fileType(fileType),
+    generated(generated)
+{
+    const QString path = filePath.toString();
+    const int slash = path.lastIndexOf(QLatin1Char('/'));
+    if (slash < 0) {
+        fileName = path;
+        return;
+    }
+    directory = sharedDirectory.isNull()
+            ? FileNodeInfo::sharedDirectory(path.left(slash)) : sharedDirectory;
+    fileName = path.mid(slash + 1);
+}
+
+Utils::FileName FileNodeInfo::filePath() const
+{
+    if (directory.isNull())
+        return Utils::FileName::fromString(fileName);
+    return Utils::FileName::fromString(directory + QLatin1Char('/') + fileName);
+}
+
+QString FileNodeInfo::sharedDirectory(const QString &directory)
+{
+    if (directory.isNull())
+        return QString();
+
+    DirectoryTable *table = directoryTable();
+    QMutexLocker locker(&table->mutex);
+    auto it = table->directories.constFind(directory);
+    if (it != table->directories.constEnd())
+        return *it;
+    table->directories.insert(directory);
+    return directory;
+}
+
+void FileNodeInfo::releaseUnusedDirectories()
+{
+    DirectoryTable *table = directoryTable();
+    QMutexLocker locker(&table->mutex);
+    for (auto it = table->directories.begin(); it != table->directories.end(); ) {
+        // Only referenced by the table itself:
+        if (it->isDetached())
+            it = table->directories.erase(it);
+        else
+            ++it;
+    }
+}
+
+int compareFilePaths(const FileNodeInfo &lhs, const FileNodeInfo &rhs)
+{
+    // Directories are shared, so files of the same directory have the same data:
+    if (!lhs.directory.isNull() && lhs.directory.constData() == rhs.directory.constData())
+        return QString::compare(lhs.fileName, rhs.fileName, Utils::HostOsInfo::fileNameCaseSensitivity());
+    return comparePaths(cursor(lhs), cursor(rhs));
+}
+
+int compareFilePaths(const FileNodeInfo &lhs, const Utils::FileName &rhs)
+{
+    const QString &path = rhs.toString();
+    return comparePaths(cursor(lhs), PathCursor(path, nullptr));
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
+
 CMakeProjectNode::CMakeProjectNode(CMakeProject *project, const Utils::FileName &dirName)
     : ProjectExplorer::ProjectNode(dirName),
       m_project(project)
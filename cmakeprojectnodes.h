@@ -33,24 +33,35 @@ class CMakeProject;
 
 namespace Internal {
 
+// File entry of the tree caches. The path is stored split into the directory, which is
+// shared by all entries of that directory (see sharedDirectory()), and the file name.
 struct FileNodeInfo
 {
     FileNodeInfo() = default;
-    FileNodeInfo(const Utils::FileName &filePath, const ProjectExplorer::FileType fileType, bool generated)
-        : filePath(filePath),
-          fileType(fileType),
-          generated(generated)
-    {}
+    FileNodeInfo(const Utils::FileName &filePath, const ProjectExplorer::FileType fileType, bool generated,
+                 const QString &sharedDirectory = QString());
 
-    Utils::FileName filePath;
+    // Only materialize the full path when handing it out, e.g. to ProjectExplorer:
+    Utils::FileName filePath() const;
+
+    // Returns the shared copy of directory. Copies are kept until releaseUnusedDirectories().
+    static QString sharedDirectory(const QString &directory);
+    static void releaseUnusedDirectories();
+
+    QString directory; // null if the path has no directory part
+    QString fileName;
     ProjectExplorer::FileType fileType = ProjectExplorer::UnknownFileType;
     bool generated = false;
 };
 
+// Compare as Utils::FileName does for the full paths, without building them:
+int compareFilePaths(const FileNodeInfo &lhs, const FileNodeInfo &rhs);
+int compareFilePaths(const FileNodeInfo &lhs, const Utils::FileName &rhs);
+
 // For sorting operations
 inline bool operator<(const FileNodeInfo &lhs, const FileNodeInfo &rhs)
 {
-    return lhs.filePath < rhs.filePath;
+    return compareFilePaths(lhs, rhs) < 0;
 }
 
 class CMakeProjectNode : public ProjectExplorer::ProjectNode
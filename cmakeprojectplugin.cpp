@@ -35,7 +35,13 @@
 #include "cmakelocatorfilter.h"
 #include "cmakesettingspage.h"
 #include "cmaketoolmanager.h"
+#include "configurescheduler.h"
 #include "cmakekitinformation.h"
+#include "cmaketrace.h"
+
+#ifdef WITH_TESTS
+#include "cmakebenchmarks.h"
+#endif
 
 #include <utils/mimetypes/mimedatabase.h>
 #include <projectexplorer/kitmanager.h>
@@ -57,6 +63,7 @@ bool CMakeProjectPlugin::initialize(const QStringList & /*arguments*/, QString *
     addAutoReleasedObject(new CMakeLocatorFilter);
 
     new CMakeToolManager(this);
+    new ConfigureScheduler(this);
 
     ProjectExplorer::KitManager::registerKitInformation(new CMakeKitInformation);
     ProjectExplorer::KitManager::registerKitInformation(new CMakeGeneratorKitInformation);
@@ -70,3 +77,22 @@ void CMakeProjectPlugin::extensionsInitialized()
     //restore the cmake tools before loading the kits
     CMakeToolManager::restoreCMakeTools();
 }
+
+ExtensionSystem::IPlugin::ShutdownFlag CMakeProjectPlugin::aboutToShutdown()
+{
+    const QString traceFile = Trace::traceFileName();
+    if (!traceFile.isEmpty())
+        Trace::writeChromeTrace(traceFile);
+    return SynchronousShutdown;
+}
+
+#ifdef WITH_TESTS
+QList<QObject *> CMakeProjectPlugin::createTestObjects() const
+{
+    // The benchmarks take minutes, keep them out of the regular test run:
+    QList<QObject *> tests;
+    if (qEnvironmentVariableIsSet("QTC_CMAKE_BENCH"))
+        tests << new CMakeBenchmarks;
+    return tests;
+}
+#endif
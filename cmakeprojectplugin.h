@@ -44,14 +44,30 @@ public:
     bool initialize(const QStringList &arguments, QString *errorMessage) override;
 
     void extensionsInitialized() override;
+    ShutdownFlag aboutToShutdown() override;
 
 #ifdef WITH_TESTS
 private slots:
     void testCMakeParser_data();
     void testCMakeParser();
+    void testCMakeParserBenchmark();
 
     void testCMakeSplitValue_data();
     void testCMakeSplitValue();
+    void testCMakeSplitValueBenchmark();
+
+    void testReparseScheduler();
+    void testGeneratedFilesIndex();
+    void testCompileCommandsSplitArguments();
+    void testGlobScopes_data();
+    void testGlobScopes();
+    void testCompileCommandsLoad();
+    void testConfigSearchIndex_data();
+    void testConfigSearchIndex();
+    void testCMakeInputLedger();
+
+private:
+    QList<QObject *> createTestObjects() const override;
 #endif
 };
 
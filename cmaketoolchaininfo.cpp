@@ -1,7 +1,7 @@
 #include "cmaketoolchaininfo.h"
+#include "cmaketrace.h"
 
 #include <QMap>
-#include <QDebug>
 
 namespace CMakeProjectManager {
 
@@ -20,7 +20,7 @@ QString CMakeToolchainInfo::arguments(const QString &userArguments, const QStrin
     }
 
     result += userArguments;
-    qDebug() << "Composed arguments: " << result;
+    qCDebug(Internal::traceCMake) << "Composed arguments:" << result;
 
     return result;
 }
@@ -33,7 +33,7 @@ QStringList CMakeToolchainInfo::arguments(const QStringList &userArguments, cons
             result << toolchainArgument(buildDirectory);
         }
     }
-    qDebug() << "Composed arguments: " << result;
+    qCDebug(Internal::traceCMake) << "Composed arguments:" << result;
     return result;
 }
 
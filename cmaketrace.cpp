@@ -0,0 +1,163 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "cmaketrace.h"
+
+#include <utils/fileutils.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+Q_LOGGING_CATEGORY(traceScan, "qtc.cmakeprojectmanager.trace.scan", QtWarningMsg)
+Q_LOGGING_CATEGORY(traceCMake, "qtc.cmakeprojectmanager.trace.cmake", QtWarningMsg)
+Q_LOGGING_CATEGORY(traceCbp, "qtc.cmakeprojectmanager.trace.cbp", QtWarningMsg)
+Q_LOGGING_CATEGORY(traceFlags, "qtc.cmakeprojectmanager.trace.flags", QtWarningMsg)
+Q_LOGGING_CATEGORY(traceCodeModel, "qtc.cmakeprojectmanager.trace.codemodel", QtWarningMsg)
+Q_LOGGING_CATEGORY(traceTree, "qtc.cmakeprojectmanager.trace.tree", QtWarningMsg)
+
+namespace {
+
+class TraceBuffer
+{
+public:
+    TraceBuffer() :
+        fileName(QString::fromLocal8Bit(qgetenv("QTC_CMAKE_TRACE_FILE")))
+    {
+        clock.start();
+        events.reserve(Trace::CAPACITY);
+    }
+
+    const QString fileName;
+    QElapsedTimer clock;
+
+    QMutex mutex;
+    QVector<Trace::Event> events; // ring buffer once CAPACITY is reached
+    int next = 0;
+};
+
+Q_GLOBAL_STATIC(TraceBuffer, traceBuffer)
+
+} // namespace
+
+qint64 Trace::now()
+{
+    return traceBuffer()->clock.nsecsElapsed();
+}
+
+bool Trace::isEnabled(const QLoggingCategory &category)
+{
+    return category.isDebugEnabled() || !traceBuffer()->fileName.isEmpty();
+}
+
+void Trace::record(const QLoggingCategory &category, const char *name, qint64 start, qint64 end)
+{
+    qCDebug(category, "%s: %.3f ms", name, (end - start) / 1000000.0);
+
+    Event event;
+    event.category = category.categoryName();
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    if (buffer->events.size() < CAPACITY)
+        buffer->events.append(event);
+    else
+        buffer->events[buffer->next] = event;
+    buffer->next = (buffer->next + 1) % CAPACITY;
+}
+
+QVector<Trace::Event> Trace::events()
+{
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    if (buffer->events.size() < CAPACITY)
+        return buffer->events;
+
+    // Oldest event first:
+    QVector<Event> result;
+    result.reserve(CAPACITY);
+    for (int i = 0; i < CAPACITY; ++i)
+        result.append(buffer->events.at((buffer->next + i) % CAPACITY));
+    return result;
+}
+
+void Trace::clear()
+{
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+}
+
+QByteArray Trace::toChromeTraceJson()
+{
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    QByteArray result = "{\"traceEvents\":[";
+    bool first = true;
+    foreach (const Event &event, events()) {
+        if (!first)
+            result.append(',');
+        first = false;
+        // Names and categories are string literals without characters that need escaping.
+        result.append("\n{\"name\":\"").append(event.name)
+                .append("\",\"cat\":\"").append(event.category)
+                .append("\",\"ph\":\"X\",\"ts\":").append(QByteArray::number(event.start / 1000.0, 'f', 3))
+                .append(",\"dur\":").append(QByteArray::number(event.duration / 1000.0, 'f', 3))
+                .append(",\"pid\":").append(pid)
+                .append(",\"tid\":").append(QByteArray::number(quint64(event.threadId)))
+                .append('}');
+    }
+    result.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+    return result;
+}
+
+bool Trace::writeChromeTrace(const QString &fileName)
+{
+    Utils::FileSaver saver(fileName, QIODevice::Text);
+    saver.write(toChromeTraceJson());
+    return saver.finalize();
+}
+
+QString Trace::traceFileName()
+{
+    return traceBuffer()->fileName;
+}
+
+TraceSpan::TraceSpan(const QLoggingCategory &category, const char *name) :
+    m_category(category), m_name(name)
+{
+    if (Trace::isEnabled(category))
+        m_start = Trace::now();
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_start >= 0)
+        Trace::record(m_category, m_name, m_start, Trace::now());
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
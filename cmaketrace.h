@@ -0,0 +1,81 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Tracing categories, enable e.g. with QT_LOGGING_RULES="qtc.cmakeprojectmanager.trace.*=true":
+Q_DECLARE_LOGGING_CATEGORY(traceScan)
+Q_DECLARE_LOGGING_CATEGORY(traceCMake)
+Q_DECLARE_LOGGING_CATEGORY(traceCbp)
+Q_DECLARE_LOGGING_CATEGORY(traceFlags)
+Q_DECLARE_LOGGING_CATEGORY(traceCodeModel)
+Q_DECLARE_LOGGING_CATEGORY(traceTree)
+
+// Keeps the last CAPACITY finished spans. Spans are recorded if their category is enabled
+// for debug output or if QTC_CMAKE_TRACE_FILE names a file; the buffer is written there in
+// Chrome trace event format (chrome://tracing) on shutdown.
+class Trace
+{
+public:
+    struct Event
+    {
+        const char *category = nullptr;
+        const char *name = nullptr;
+        qint64 start = 0;    // ns since the first trace call
+        qint64 duration = 0; // ns
+        quintptr threadId = 0;
+    };
+
+    static const int CAPACITY = 4096;
+
+    static qint64 now();
+    static bool isEnabled(const QLoggingCategory &category);
+
+    static void record(const QLoggingCategory &category, const char *name, qint64 start, qint64 end);
+
+    static QVector<Event> events();
+    static void clear();
+
+    static QByteArray toChromeTraceJson();
+    static bool writeChromeTrace(const QString &fileName);
+    static QString traceFileName();
+};
+
+// Records the time between construction and destruction as one span.
+class TraceSpan
+{
+public:
+    TraceSpan(const QLoggingCategory &category, const char *name);
+    ~TraceSpan();
+
+private:
+    const QLoggingCategory &m_category;
+    const char *m_name;
+    qint64 m_start = -1;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,415 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "compilecommands.h"
+
+#include <utils/qtcprocess.h>
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <cstring>
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+#endif
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+// Pull scanner for the subset of JSON found in compilation databases. It works directly on
+// the (mapped) file, so only the strings of the current entry are ever materialized.
+class JsonScanner
+{
+public:
+    JsonScanner(const char *begin, const char *end) : m_pos(begin), m_end(end) { }
+
+    bool atEnd() { skipSpace(); return m_pos == m_end; }
+    bool failed() const { return m_failed; }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (m_pos == m_end || *m_pos != c)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+            m_failed = true;
+    }
+
+    QString readString()
+    {
+        QString result;
+        if (!consume('"')) {
+            m_failed = true;
+            return result;
+        }
+        const char *run = m_pos;
+        while (m_pos != m_end && *m_pos != '"') {
+            if (*m_pos != '\\') {
+                ++m_pos;
+                continue;
+            }
+            result.append(QString::fromUtf8(run, int(m_pos - run)));
+            if (++m_pos == m_end)
+                break;
+            const char escaped = *m_pos++;
+            switch (escaped) {
+            case 'b': result.append(QLatin1Char('\b')); break;
+            case 'f': result.append(QLatin1Char('\f')); break;
+            case 'n': result.append(QLatin1Char('\n')); break;
+            case 'r': result.append(QLatin1Char('\r')); break;
+            case 't': result.append(QLatin1Char('\t')); break;
+            case 'u':
+                if (m_end - m_pos >= 4) {
+                    // Surrogate pairs arrive as two escapes, QString puts them together:
+                    result.append(QChar(ushort(QByteArray(m_pos, 4).toUInt(nullptr, 16))));
+                    m_pos += 4;
+                }
+                break;
+            default: result.append(QLatin1Char(escaped)); break;
+            }
+            run = m_pos;
+        }
+        result.append(QString::fromUtf8(run, int(m_pos - run)));
+        if (m_pos == m_end)
+            m_failed = true;
+        else
+            ++m_pos;
+        return result;
+    }
+
+    QStringList readStringArray()
+    {
+        QStringList result;
+        expect('[');
+        if (consume(']'))
+            return result;
+        do {
+            result.append(readString());
+        } while (!m_failed && consume(','));
+        expect(']');
+        return result;
+    }
+
+    void skipValue()
+    {
+        skipSpace();
+        if (m_pos == m_end) {
+            m_failed = true;
+        } else if (*m_pos == '"') {
+            readString();
+        } else if (*m_pos == '[' || *m_pos == '{') {
+            const char close = *m_pos == '[' ? ']' : '}';
+            ++m_pos;
+            if (consume(close))
+                return;
+            do {
+                if (close == '}') {
+                    readString();
+                    expect(':');
+                }
+                skipValue();
+            } while (!m_failed && consume(','));
+            expect(close);
+        } else {
+            // Numbers, true, false and null:
+            while (m_pos != m_end && !strchr(",]} \t\r\n", *m_pos))
+                ++m_pos;
+        }
+    }
+
+private:
+    void skipSpace()
+    {
+        while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n'))
+            ++m_pos;
+    }
+
+    const char *m_pos;
+    const char *m_end;
+    bool m_failed = false;
+};
+
+QString flagsKey(const CompileCommands::Flags &flags)
+{
+    return flags.includePaths.join(QLatin1Char('\n')) + QLatin1Char('\0')
+            + QString::fromUtf8(flags.defines) + QLatin1Char('\0')
+            + flags.flags.join(QLatin1Char('\n'));
+}
+
+// The target name, from object files like ".../CMakeFiles/<target>.dir/main.cpp.o":
+QString targetOf(const QStringList &arguments)
+{
+    static const QRegularExpression objectDir(QLatin1String("CMakeFiles/([^/]+)\\.dir/"));
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        if (argument == QLatin1String("-o") || argument.startsWith(QLatin1String("/Fo"))
+                || argument.startsWith(QLatin1String("-Fo"))) {
+            const QString output = argument.size() > 3 ? argument : arguments.value(i + 1);
+            const QRegularExpressionMatch match = objectDir.match(output);
+            if (match.hasMatch())
+                return match.captured(1);
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+Utils::FileName CompileCommands::databaseFile(const Utils::FileName &buildDirectory)
+{
+    return Utils::FileName(buildDirectory).appendPath(QLatin1String("compile_commands.json"));
+}
+
+bool CompileCommands::load(const Utils::FileName &databaseFile)
+{
+    clear();
+
+    QFile file(databaseFile.toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // Databases can be huge, so map the file instead of reading it, if possible:
+    QByteArray contents;
+    const char *begin = reinterpret_cast<const char *>(file.map(0, file.size()));
+    if (!begin) {
+        contents = file.readAll();
+        begin = contents.constData();
+    }
+    JsonScanner scanner(begin, begin + (contents.isNull() ? file.size() : contents.size()));
+
+    // Equal strings of different entries share their data:
+    QSet<QString> strings;
+    auto intern = [&strings](QStringList &list) {
+        for (QString &string : list) {
+            auto it = strings.constFind(string);
+            if (it == strings.constEnd())
+                strings.insert(string);
+            else
+                string = *it;
+        }
+    };
+    QHash<QString, int> flagSetIndex;
+
+    scanner.expect('[');
+    if (scanner.consume(']'))
+        return !scanner.failed();
+    do {
+        QString directory;
+        QString fileName;
+        QStringList arguments;
+        QString command;
+        scanner.expect('{');
+        if (!scanner.consume('}')) {
+            do {
+                const QString key = scanner.readString();
+                scanner.expect(':');
+                if (key == QLatin1String("directory"))
+                    directory = scanner.readString();
+                else if (key == QLatin1String("file"))
+                    fileName = scanner.readString();
+                else if (key == QLatin1String("arguments"))
+                    arguments = scanner.readStringArray();
+                else if (key == QLatin1String("command"))
+                    command = scanner.readString();
+                else
+                    scanner.skipValue();
+            } while (!scanner.failed() && scanner.consume(','));
+            scanner.expect('}');
+        }
+
+        if (arguments.isEmpty() && !command.isEmpty())
+            arguments = Utils::QtcProcess::splitArgs(command, Utils::HostOsInfo::hostOs());
+        if (scanner.failed() || fileName.isEmpty() || arguments.isEmpty())
+            continue;
+
+        Flags flags = splitArguments(arguments, directory);
+        const QString key = flagsKey(flags);
+        auto it = flagSetIndex.constFind(key);
+        if (it == flagSetIndex.constEnd()) {
+            intern(flags.includePaths);
+            intern(flags.flags);
+            it = flagSetIndex.insert(key, m_flagSets.size());
+            m_flagSets.append(flags);
+        }
+
+        const Utils::FileName source = Utils::FileName::fromString(
+                    QDir::cleanPath(QDir(directory).absoluteFilePath(fileName)));
+        m_sources.insert(source, it.value());
+
+        const QString target = targetOf(arguments);
+        if (!target.isEmpty()) {
+            QHash<QString, int> &targets = isCSource(fileName) ? m_targetsC : m_targetsCxx;
+            if (!targets.contains(target))
+                targets.insert(target, it.value());
+        }
+    } while (!scanner.failed() && scanner.consume(','));
+    scanner.expect(']');
+
+    return !scanner.failed();
+}
+
+void CompileCommands::clear()
+{
+    m_flagSets.clear();
+    m_sources.clear();
+    m_targetsC.clear();
+    m_targetsCxx.clear();
+}
+
+bool CompileCommands::isCSource(const QString &fileName)
+{
+    return fileName.endsWith(QLatin1String(".c"));
+}
+
+const CompileCommands::Flags *CompileCommands::flagsFor(const Utils::FileName &source) const
+{
+    auto it = m_sources.constFind(source);
+    return it == m_sources.constEnd() ? nullptr : &m_flagSets.at(it.value());
+}
+
+const CompileCommands::Flags *CompileCommands::flagsForTarget(const QString &target, bool c) const
+{
+    const QHash<QString, int> &targets = c ? m_targetsC : m_targetsCxx;
+    auto it = targets.constFind(target);
+    return it == targets.constEnd() ? nullptr : &m_flagSets.at(it.value());
+}
+
+CompileCommands::Flags CompileCommands::splitArguments(const QStringList &arguments,
+                                                       const QString &directory)
+{
+    Flags result;
+    const QDir dir(directory);
+
+    // Options taking the next argument as value, if not attached:
+    auto value = [&arguments](int &i, const QString &option) -> QString {
+        const QString &argument = arguments.at(i);
+        if (argument.size() > option.size())
+            return argument.mid(option.size());
+        return ++i < arguments.size() ? arguments.at(i) : QString();
+    };
+
+    static const QStringList valueOptions = {
+        "-include", "-imacros", "-isysroot", "--sysroot", "-x", "-iquote", "-Xclang"
+    };
+    // Per file output options, dropped so that equal flags of different files compare equal:
+    static const QStringList outputOptions = { "-o", "-MF", "-MT", "-MQ" };
+    static const QStringList outputFlags = { "-c", "-MD", "-MMD" };
+
+    // Skip the compiler itself:
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        if (outputFlags.contains(argument)
+                || argument.startsWith(QLatin1String("/Fo"))
+                || argument.startsWith(QLatin1String("-Fo"))) {
+            continue;
+        } else if (outputOptions.contains(argument)) {
+            ++i;
+        } else if (valueOptions.contains(argument)) {
+            result.flags.append(argument);
+            if (++i < arguments.size())
+                result.flags.append(arguments.at(i));
+        } else if (argument.startsWith(QLatin1String("-I"))) {
+            result.includePaths.append(QDir::cleanPath(dir.absoluteFilePath(value(i, QLatin1String("-I")))));
+        } else if (argument == QLatin1String("-isystem")) {
+            result.includePaths.append(QDir::cleanPath(dir.absoluteFilePath(value(i, argument))));
+        } else if (argument.startsWith(QLatin1String("-D"))) {
+            QString define = value(i, QLatin1String("-D"));
+            const int assign = define.indexOf(QLatin1Char('='));
+            if (assign >= 0)
+                define[assign] = QLatin1Char(' ');
+            result.defines.append("#define " + define.toUtf8() + '\n');
+        } else if (argument.startsWith(QLatin1String("-U"))) {
+            result.defines.append("#undef " + value(i, QLatin1String("-U")).toUtf8() + '\n');
+        } else if (!argument.startsWith(QLatin1Char('-'))) {
+            continue; // the source file
+        } else {
+            result.flags.append(argument);
+        }
+    }
+    return result;
+}
+
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testCompileCommandsSplitArguments()
+{
+    const QStringList arguments = {
+        "/usr/bin/c++", "-DAPP_VERSION=\"1.0\"", "-D", "QT_CORE_LIB", "-UNDEBUG",
+        "-I../include", "-isystem", "/opt/qt/include", "-include", "pch.h", "-fPIC",
+        "-std=gnu++11", "-MD", "-MT", "CMakeFiles/app.dir/main.cpp.o",
+        "-MF", "CMakeFiles/app.dir/main.cpp.o.d", "-o", "CMakeFiles/app.dir/main.cpp.o",
+        "-c", "/src/main.cpp"
+    };
+    const CompileCommands::Flags flags = CompileCommands::splitArguments(arguments, "/build");
+    QCOMPARE(flags.includePaths, QStringList({ "/include", "/opt/qt/include" }));
+    QCOMPARE(flags.defines, QByteArray("#define APP_VERSION \"1.0\"\n"
+                                       "#define QT_CORE_LIB\n"
+                                       "#undef NDEBUG\n"));
+    QCOMPARE(flags.flags, QStringList({ "-include", "pch.h", "-fPIC", "-std=gnu++11" }));
+}
+
+void CMakeProjectPlugin::testCompileCommandsLoad()
+{
+    QTemporaryDir buildDir;
+    QVERIFY(buildDir.isValid());
+    const Utils::FileName database
+            = CompileCommands::databaseFile(Utils::FileName::fromString(buildDir.path()));
+    QFile file(database.toString());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("[\n"
+               "{ \"directory\": \"/build\", \"command\": \"/usr/bin/c++ '-DNAME=\\\"a b\\\"' "
+               "-o CMakeFiles/app.dir/main.cpp.o -c /src/main.cpp\", \"file\": \"/src/main.cpp\" },\n"
+               "{ \"directory\": \"/build\", \"arguments\": [\"/usr/bin/c++\", \"-DNAME=\\\"a b\\\"\", "
+               "\"-o\", \"CMakeFiles/app.dir/util.cpp.o\", \"-c\", \"../src/util.cpp\"], "
+               "\"file\": \"../src/util.cpp\", \"output\": null },\n"
+               "{ \"directory\": \"/build\", \"arguments\": [\"/usr/bin/cc\", \"-DPLAIN_\\u00e4\", "
+               "\"-o\", \"CMakeFiles/lib.dir/lib.c.o\", \"-c\", \"/src/lib.c\"], \"file\": \"/src/lib.c\" }\n"
+               "]\n");
+    file.close();
+
+    CompileCommands commands;
+    QVERIFY(commands.load(database));
+    const CompileCommands::Flags *main = commands.flagsFor(Utils::FileName::fromString("/src/main.cpp"));
+    const CompileCommands::Flags *util = commands.flagsFor(Utils::FileName::fromString("/src/util.cpp"));
+    const CompileCommands::Flags *lib = commands.flagsFor(Utils::FileName::fromString("/src/lib.c"));
+    QVERIFY(main && util && lib);
+    QCOMPARE(main, util); // one shared flag set
+    QCOMPARE(main->defines, QByteArray("#define NAME \"a b\"\n"));
+    QCOMPARE(lib->defines, QString::fromUtf8("#define PLAIN_\u00e4\n").toUtf8());
+    QCOMPARE(commands.flagsForTarget("app", false), main);
+    QCOMPARE(commands.flagsForTarget("lib", true), lib);
+    QVERIFY(!commands.flagsForTarget("lib", false));
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// The compiler invocations cmake records in compile_commands.json, split into what the
+// code model needs, per source file.
+class CompileCommands
+{
+public:
+    struct Flags
+    {
+        QStringList includePaths;
+        QByteArray defines;
+        QStringList flags; // everything else, without compiler, input and output
+    };
+
+    static Utils::FileName databaseFile(const Utils::FileName &buildDirectory);
+
+    bool load(const Utils::FileName &databaseFile);
+    void clear();
+    bool isEmpty() const { return m_sources.isEmpty(); }
+
+    // Null if cmake did not record a command for the source:
+    const Flags *flagsFor(const Utils::FileName &source) const;
+    // The flags of the first C (or C++) source of the target:
+    const Flags *flagsForTarget(const QString &target, bool c) const;
+
+    static bool isCSource(const QString &fileName);
+    static Flags splitArguments(const QStringList &arguments, const QString &directory);
+
+private:
+    // Sources usually share few distinct flag sets, so each set is only stored once:
+    QVector<Flags> m_flagSets;
+    QHash<Utils::FileName, int> m_sources;
+    QHash<QString, int> m_targetsC;
+    QHash<QString, int> m_targetsCxx;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -94,6 +94,8 @@ QVariant ConfigModel::data(const QModelIndex &index, int role) const
             return item.type;
         case ItemValuesRole:
             return item.values;
+        case ItemChangedRole:
+            return item.isUserChanged || item.isUserNew || item.isCMakeChanged;
         }
     }
 
@@ -227,9 +229,10 @@ void ConfigModel::appendConfiguration(const QString &key,
     InternalDataItem internalItem(item);
     internalItem.isUserNew = true;
 
-    beginResetModel();
+    const int row = m_configuration.count();
+    beginInsertRows(QModelIndex(), row, row);
     m_configuration.append(internalItem);
-    endResetModel();
+    endInsertRows();
 }
 
 void ConfigModel::setConfiguration(const QList<ConfigModel::DataItem> &config)
@@ -267,32 +270,109 @@ void ConfigModel::setConfiguration(const QList<ConfigModel::DataItem> &config)
     for (; newIt != newEndIt; ++newIt)
         result << InternalDataItem(*newIt);
 
-    beginResetModel();
-    m_configuration = result;
-    endResetModel();
+    applyConfiguration(result);
+}
+
+// Turns m_configuration into newConfiguration (sorted by key) using row level
+// insertions, removals and data changes, so attached views keep their state.
+void ConfigModel::applyConfiguration(const QList<InternalDataItem> &newConfiguration)
+{
+    int firstChanged = -1;
+    int lastChanged = -1;
+    auto flushChanged = [this, &firstChanged, &lastChanged]() {
+        if (firstChanged < 0)
+            return;
+        emit dataChanged(index(firstChanged, 0), index(lastChanged, columnCount(QModelIndex()) - 1));
+        firstChanged = lastChanged = -1;
+    };
+
+    int row = 0;
+    int n = 0;
+    while (row < m_configuration.count() && n < newConfiguration.count()) {
+        const QString &oldKey = m_configuration.at(row).key;
+        const QString &newKey = newConfiguration.at(n).key;
+        if (newKey < oldKey) {
+            // Insert all new entries sorting before the current old one:
+            flushChanged();
+            int last = n;
+            while (last + 1 < newConfiguration.count() && newConfiguration.at(last + 1).key < oldKey)
+                ++last;
+            beginInsertRows(QModelIndex(), row, row + last - n);
+            for (int i = n; i <= last; ++i)
+                m_configuration.insert(row + i - n, newConfiguration.at(i));
+            endInsertRows();
+            row += last - n + 1;
+            n = last + 1;
+        } else if (newKey > oldKey) {
+            // Remove all old entries that are gone:
+            flushChanged();
+            int last = row;
+            while (last + 1 < m_configuration.count() && m_configuration.at(last + 1).key < newKey)
+                ++last;
+            beginRemoveRows(QModelIndex(), row, last);
+            m_configuration.erase(m_configuration.begin() + row, m_configuration.begin() + last + 1);
+            endRemoveRows();
+        } else {
+            if (!isSameItem(m_configuration.at(row), newConfiguration.at(n))) {
+                m_configuration[row] = newConfiguration.at(n);
+                if (firstChanged >= 0 && lastChanged + 1 != row)
+                    flushChanged();
+                if (firstChanged < 0)
+                    firstChanged = row;
+                lastChanged = row;
+            }
+            ++row;
+            ++n;
+        }
+    }
+    flushChanged();
+
+    // Remove trailing old entries:
+    if (row < m_configuration.count()) {
+        beginRemoveRows(QModelIndex(), row, m_configuration.count() - 1);
+        m_configuration.erase(m_configuration.begin() + row, m_configuration.end());
+        endRemoveRows();
+    }
+
+    // Append trailing new entries:
+    if (n < newConfiguration.count()) {
+        const int first = m_configuration.count();
+        beginInsertRows(QModelIndex(), first, first + newConfiguration.count() - n - 1);
+        for (; n < newConfiguration.count(); ++n)
+            m_configuration.append(newConfiguration.at(n));
+        endInsertRows();
+    }
 }
 
 void ConfigModel::flush()
 {
-    beginResetModel();
+    if (m_configuration.isEmpty())
+        return;
+
+    beginRemoveRows(QModelIndex(), 0, m_configuration.count() - 1);
     m_configuration.clear();
-    endResetModel();
+    endRemoveRows();
 }
 
 void ConfigModel::resetAllChanges()
 {
-    const QList<InternalDataItem> tmp
-            = Utils::filtered(m_configuration,
-                              [](const InternalDataItem &i) { return !i.isUserNew; });
-
-    beginResetModel();
-    m_configuration = Utils::transform(tmp, [](const InternalDataItem &i) -> InternalDataItem {
-        InternalDataItem ni(i);
-        ni.newValue.clear();
-        ni.isUserChanged = false;
-        return ni;
-    });
-    endResetModel();
+    // Walk backwards, so that removing rows does not shift the rows still to be visited:
+    for (int row = m_configuration.count() - 1; row >= 0; --row) {
+        if (m_configuration.at(row).isUserNew) {
+            int first = row;
+            while (first > 0 && m_configuration.at(first - 1).isUserNew)
+                --first;
+            beginRemoveRows(QModelIndex(), first, row);
+            m_configuration.erase(m_configuration.begin() + first, m_configuration.begin() + row + 1);
+            endRemoveRows();
+            row = first;
+        } else if (m_configuration.at(row).isUserChanged) {
+            InternalDataItem &item = m_configuration[row];
+            item.newValue.clear();
+            item.isUserChanged = false;
+            emit dataChanged(index(row, 0), index(row, columnCount(QModelIndex()) - 1));
+        }
+    }
 }
 
 bool ConfigModel::hasChanges() const
@@ -331,6 +411,14 @@ const ConfigModel::InternalDataItem &ConfigModel::itemAtRow(int row) const
     return m_configuration[row];
 }
 
+bool ConfigModel::isSameItem(const InternalDataItem &a, const InternalDataItem &b)
+{
+    return a.key == b.key && a.type == b.type && a.isAdvanced == b.isAdvanced
+            && a.value == b.value && a.description == b.description && a.values == b.values
+            && a.isUserChanged == b.isUserChanged && a.isUserNew == b.isUserNew
+            && a.isCMakeChanged == b.isCMakeChanged && a.newValue == b.newValue;
+}
+
 ConfigModel::InternalDataItem::InternalDataItem(const ConfigModel::DataItem &item) : DataItem(item),
     isUserChanged(false), isUserNew(false), isCMakeChanged(false)
 { }
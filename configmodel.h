@@ -36,7 +36,8 @@ class ConfigModel : public QAbstractTableModel
 public:
     enum Roles {
         ItemTypeRole = Qt::UserRole,
-        ItemValuesRole
+        ItemValuesRole,
+        ItemChangedRole
     };
 
     class DataItem {
@@ -88,6 +89,9 @@ private:
         QString newValue;
     };
 
+    void applyConfiguration(const QList<InternalDataItem> &newConfiguration);
+    static bool isSameItem(const InternalDataItem &a, const InternalDataItem &b);
+
     InternalDataItem &itemAtRow(int row);
     const InternalDataItem &itemAtRow(int row) const;
     QList<InternalDataItem> m_configuration;
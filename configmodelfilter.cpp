@@ -0,0 +1,414 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+
+#include "configmodelfilter.h"
+#include "configmodel.h"
+
+#include <utils/runextensions.h>
+
+#include <algorithm>
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+#endif
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+// Smaller configurations are filtered synchronously, that is faster than a thread round trip.
+const int ASYNC_SEARCH_THRESHOLD = 2000;
+
+bool isNegative(const QString &arg)
+{
+    return arg == QLatin1String("no") || arg == QLatin1String("false")
+            || arg == QLatin1String("off") || arg == QLatin1String("0");
+}
+
+int typeFromString(const QString &arg)
+{
+    if (arg == QLatin1String("bool") || arg == QLatin1String("boolean"))
+        return ConfigModel::DataItem::BOOLEAN;
+    if (arg == QLatin1String("file") || arg == QLatin1String("filepath"))
+        return ConfigModel::DataItem::FILE;
+    if (arg == QLatin1String("path") || arg == QLatin1String("dir") || arg == QLatin1String("directory"))
+        return ConfigModel::DataItem::DIRECTORY;
+    if (arg == QLatin1String("string"))
+        return ConfigModel::DataItem::STRING;
+    if (arg == QLatin1String("unknown") || arg == QLatin1String("internal"))
+        return ConfigModel::DataItem::UNKNOWN;
+    return -1;
+}
+
+} // namespace
+
+// --------------------------------------------------------------------
+// ConfigSearchIndex:
+// --------------------------------------------------------------------
+
+ConfigSearchIndex::ConfigSearchIndex(const QVector<Entry> &entries)
+{
+    m_entries.reserve(entries.count());
+    for (int row = 0; row < entries.count(); ++row) {
+        Entry entry = entries.at(row);
+        entry.key = entry.key.toLower();
+        entry.value = entry.value.toLower();
+        entry.description = entry.description.toLower();
+        addTokens(entry.key, row, KeyField);
+        addTokens(entry.value, row, ValueField);
+        addTokens(entry.description, row, DescriptionField);
+        m_entries.append(entry);
+    }
+
+    std::sort(m_postings.begin(), m_postings.end(), [](const Posting &a, const Posting &b) {
+        return a.token < b.token;
+    });
+}
+
+void ConfigSearchIndex::addTokens(const QString &lowerText, int row, Field field)
+{
+    if (lowerText.isEmpty())
+        return;
+
+    // The whole text is a token too, so "cmake_build" finds CMAKE_BUILD_TYPE and "/usr" paths:
+    m_postings.append({ lowerText, row, field });
+
+    int start = -1;
+    for (int i = 0; i <= lowerText.size(); ++i) {
+        const bool isWord = i < lowerText.size() && lowerText.at(i).isLetterOrNumber();
+        if (isWord && start < 0) {
+            start = i;
+        } else if (!isWord && start >= 0) {
+            if (i - start != lowerText.size())
+                m_postings.append({ lowerText.mid(start, i - start), row, field });
+            start = -1;
+        }
+    }
+}
+
+QVector<bool> ConfigSearchIndex::matchPrefix(const QString &prefix, int fields) const
+{
+    QVector<bool> result(m_entries.count(), false);
+    auto it = std::lower_bound(m_postings.constBegin(), m_postings.constEnd(), prefix,
+                               [](const Posting &p, const QString &t) { return p.token < t; });
+    for (; it != m_postings.constEnd() && it->token.startsWith(prefix); ++it) {
+        if (it->field & fields)
+            result[it->row] = true;
+    }
+    return result;
+}
+
+QVector<bool> ConfigSearchIndex::matchSubstring(const QString &needle, int fields) const
+{
+    QVector<bool> result(m_entries.count(), false);
+    for (int row = 0; row < m_entries.count(); ++row) {
+        const Entry &e = m_entries.at(row);
+        result[row] = ((fields & KeyField) && e.key.contains(needle))
+                || ((fields & ValueField) && e.value.contains(needle))
+                || ((fields & DescriptionField) && e.description.contains(needle));
+    }
+    return result;
+}
+
+QVector<bool> ConfigSearchIndex::matchTerm(const QString &term) const
+{
+    const int colon = term.indexOf(QLatin1Char(':'));
+    if (colon > 0) {
+        const QString name = term.left(colon);
+        const QString arg = term.mid(colon + 1);
+        if (name == QLatin1String("key")) {
+            return arg.startsWith(QLatin1Char('*')) ? matchSubstring(arg.mid(1), KeyField)
+                                                    : matchPrefix(arg, KeyField);
+        } else if (name == QLatin1String("type")) {
+            const int type = typeFromString(arg);
+            QVector<bool> result(m_entries.count(), arg.isEmpty());
+            if (type >= 0) {
+                for (int row = 0; row < m_entries.count(); ++row)
+                    result[row] = m_entries.at(row).type == type;
+            }
+            return result;
+        } else if (name == QLatin1String("changed")) {
+            const bool changed = !isNegative(arg);
+            QVector<bool> result(m_entries.count());
+            for (int row = 0; row < m_entries.count(); ++row)
+                result[row] = m_entries.at(row).changed == changed;
+            return result;
+        }
+        // Unknown filter name: search for the term as it is, it might be part of a path.
+    }
+
+    if (term.startsWith(QLatin1Char('*')))
+        return matchSubstring(term.mid(1), AllFields);
+    return matchPrefix(term, AllFields);
+}
+
+QVector<bool> ConfigSearchIndex::match(const QString &query, const QFutureInterfaceBase *fi) const
+{
+    QVector<bool> result(m_entries.count(), true);
+    const QStringList terms = query.toLower().split(QLatin1Char(' '), QString::SkipEmptyParts);
+    foreach (const QString &term, terms) {
+        if (fi && fi->isCanceled())
+            return QVector<bool>();
+        const QVector<bool> termResult = matchTerm(term);
+        for (int row = 0; row < result.count(); ++row)
+            result[row] = result.at(row) && termResult.at(row);
+    }
+    return result;
+}
+
+// --------------------------------------------------------------------
+// ConfigModelFilter:
+// --------------------------------------------------------------------
+
+ConfigModelFilter::ConfigModelFilter(QObject *parent) : QSortFilterProxyModel(parent)
+{
+    connect(&m_watcher, &QFutureWatcherBase::finished, this, &ConfigModelFilter::searchFinished);
+}
+
+ConfigModelFilter::~ConfigModelFilter()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+void ConfigModelFilter::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (QAbstractItemModel *old = this->sourceModel()) {
+        disconnect(old, &QAbstractItemModel::rowsInserted, this, &ConfigModelFilter::sourceRowsChanged);
+        disconnect(old, &QAbstractItemModel::rowsRemoved, this, &ConfigModelFilter::sourceRowsChanged);
+        disconnect(old, &QAbstractItemModel::dataChanged, this, &ConfigModelFilter::sourceDataChanged);
+        disconnect(old, &QAbstractItemModel::modelReset, this, &ConfigModelFilter::sourceRowsChanged);
+    }
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &ConfigModelFilter::sourceRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &ConfigModelFilter::sourceRowsChanged);
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &ConfigModelFilter::sourceDataChanged);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &ConfigModelFilter::sourceRowsChanged);
+    }
+    sourceRowsChanged();
+}
+
+QString ConfigModelFilter::searchText() const
+{
+    return m_searchText;
+}
+
+void ConfigModelFilter::setSearchText(const QString &text)
+{
+    const QString searchText = text.simplified();
+    if (searchText == m_searchText)
+        return;
+    m_searchText = searchText;
+
+    if (m_searchText.isEmpty()) {
+        m_restartSearch = false;
+        m_watcher.cancel();
+        m_accepted.clear();
+        invalidateFilter();
+        return;
+    }
+    startSearch();
+}
+
+bool ConfigModelFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent))
+        return false;
+    if (m_searchText.isEmpty())
+        return true;
+    // Rows not covered by the last result are shown until the running search finishes:
+    return sourceRow >= m_accepted.count() || m_accepted.at(sourceRow);
+}
+
+void ConfigModelFilter::search(QFutureInterface<SearchResult> &fi,
+                               std::shared_ptr<const ConfigSearchIndex> index,
+                               const QVector<ConfigSearchIndex::Entry> &entries,
+                               const QString &query)
+{
+    if (!index)
+        index = std::make_shared<const ConfigSearchIndex>(entries);
+    if (fi.isCanceled())
+        return;
+    const QVector<bool> accepted = index->match(query, &fi);
+    if (!fi.isCanceled())
+        fi.reportResult({ index, accepted });
+}
+
+void ConfigModelFilter::sourceRowsChanged()
+{
+    // The last result is indexed by source row, which does not fit the rows anymore:
+    if (!m_accepted.isEmpty()) {
+        m_accepted.clear();
+        invalidateFilter();
+    }
+    m_index.reset();
+    m_indexDirty = false;
+    if (!m_searchText.isEmpty())
+        startSearch();
+}
+
+void ConfigModelFilter::sourceDataChanged()
+{
+    // Editing a value changes one row at a time, so do not re-index the whole
+    // configuration for each edit. The next search picks up the new data:
+    m_indexDirty = true;
+}
+
+void ConfigModelFilter::startSearch()
+{
+    if (m_watcher.isRunning()) {
+        // Restart when the obsolete search is done:
+        m_restartSearch = true;
+        m_watcher.cancel();
+        return;
+    }
+
+    if (m_indexDirty) {
+        m_index.reset();
+        m_indexDirty = false;
+    }
+    const QVector<ConfigSearchIndex::Entry> entries = m_index ? QVector<ConfigSearchIndex::Entry>() : snapshot();
+    const int count = m_index ? m_index->count() : entries.count();
+    if (count < ASYNC_SEARCH_THRESHOLD) {
+        std::shared_ptr<const ConfigSearchIndex> index = m_index;
+        if (!index)
+            index = std::make_shared<const ConfigSearchIndex>(entries);
+        applyResult({ index, index->match(m_searchText) });
+        return;
+    }
+
+    m_watcher.setFuture(Utils::runAsync(&ConfigModelFilter::search, m_index, entries, m_searchText));
+}
+
+void ConfigModelFilter::searchFinished()
+{
+    if (m_restartSearch) {
+        m_restartSearch = false;
+        if (!m_searchText.isEmpty())
+            startSearch();
+        return;
+    }
+
+    const QFuture<SearchResult> future = m_watcher.future();
+    if (future.isCanceled() || future.resultCount() == 0)
+        return;
+    applyResult(future.result());
+}
+
+void ConfigModelFilter::applyResult(const SearchResult &result)
+{
+    m_index = result.index;
+    m_accepted = result.accepted;
+    invalidateFilter();
+}
+
+QVector<ConfigSearchIndex::Entry> ConfigModelFilter::snapshot() const
+{
+    QVector<ConfigSearchIndex::Entry> result;
+    const QAbstractItemModel *model = sourceModel();
+    if (!model)
+        return result;
+
+    const int rows = model->rowCount(QModelIndex());
+    result.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        const QModelIndex keyIndex = model->index(row, 0);
+        ConfigSearchIndex::Entry entry;
+        entry.key = keyIndex.data(Qt::EditRole).toString();
+        entry.value = model->index(row, 1).data(Qt::DisplayRole).toString();
+        entry.description = keyIndex.data(Qt::ToolTipRole).toString();
+        entry.type = keyIndex.data(ConfigModel::ItemTypeRole).toInt();
+        entry.changed = keyIndex.data(ConfigModel::ItemChangedRole).toBool();
+        result.append(entry);
+    }
+    return result;
+}
+
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testConfigSearchIndex_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QList<int>>("rows");
+
+    QTest::newRow("empty") << "" << QList<int>({ 0, 1, 2, 3, 4 });
+    QTest::newRow("key prefix") << "cmake" << QList<int>({ 0, 1 });
+    QTest::newRow("word prefix") << "build" << QList<int>({ 0, 2, 4 });
+    QTest::newRow("case insensitive") << "Install" << QList<int>({ 1 });
+    QTest::newRow("no infix") << "ake" << QList<int>();
+    QTest::newRow("whole value") << "/usr" << QList<int>({ 1, 3 });
+    QTest::newRow("substring") << "*ake" << QList<int>({ 0, 1, 3 });
+    QTest::newRow("key") << "key:build" << QList<int>({ 0, 4 });
+    QTest::newRow("key substring") << "key:*prefix" << QList<int>({ 1 });
+    QTest::newRow("type bool") << "type:bool" << QList<int>({ 2, 4 });
+    QTest::newRow("type path") << "type:path" << QList<int>({ 1 });
+    QTest::newRow("type file") << "type:file" << QList<int>({ 3 });
+    QTest::newRow("type string") << "type:string" << QList<int>({ 0 });
+    QTest::newRow("type unknown name") << "type:foo" << QList<int>();
+    QTest::newRow("type empty") << "type:" << QList<int>({ 0, 1, 2, 3, 4 });
+    QTest::newRow("changed") << "changed:yes" << QList<int>({ 1, 4 });
+    QTest::newRow("not changed") << "changed:no" << QList<int>({ 0, 2, 3 });
+    QTest::newRow("word and changed") << "build changed:yes" << QList<int>({ 4 });
+    QTest::newRow("type and key") << "type:bool key:with" << QList<int>({ 2 });
+    QTest::newRow("changed and substring") << "changed:no  *usr" << QList<int>({ 3 });
+    QTest::newRow("no match") << "cmake type:bool" << QList<int>();
+}
+
+void CMakeProjectPlugin::testConfigSearchIndex()
+{
+    QFETCH(QString, query);
+    QFETCH(QList<int>, rows);
+
+    auto entry = [](const QString &key, const QString &value, const QString &description,
+                    int type, bool changed) {
+        ConfigSearchIndex::Entry e;
+        e.key = key;
+        e.value = value;
+        e.description = description;
+        e.type = type;
+        e.changed = changed;
+        return e;
+    };
+    const ConfigSearchIndex index({
+        entry("CMAKE_BUILD_TYPE", "Debug", "Choose the type of build", ConfigModel::DataItem::STRING, false),
+        entry("CMAKE_INSTALL_PREFIX", "/usr/local", "Install path prefix", ConfigModel::DataItem::DIRECTORY, true),
+        entry("WITH_TESTS", "ON", "Build the unit tests", ConfigModel::DataItem::BOOLEAN, false),
+        entry("QT_QMAKE_EXECUTABLE", "/usr/bin/qmake", QString(), ConfigModel::DataItem::FILE, false),
+        entry("BUILD_SHARED_LIBS", "OFF", "Build shared libraries", ConfigModel::DataItem::BOOLEAN, true)
+    });
+
+    const QVector<bool> accepted = index.match(query);
+    QCOMPARE(accepted.count(), index.count());
+    QList<int> actual;
+    for (int row = 0; row < accepted.count(); ++row) {
+        if (accepted.at(row))
+            actual.append(row);
+    }
+    QCOMPARE(actual, rows);
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
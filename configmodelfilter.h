@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <QFutureWatcher>
+#include <QSortFilterProxyModel>
+#include <QVector>
+
+#include <memory>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Token index over key, value and description of the configuration entries.
+//
+// Query syntax (case insensitive, all terms must match):
+//   foo          some word of key, value or description starts with "foo"
+//   *foo         key, value or description contains "foo"
+//   key:foo      same as above, but only the key is searched ("key:*foo" for substrings)
+//   type:bool    entry type: bool, string, path, file or unknown
+//   changed:yes  entry was changed by the user or by cmake ("changed:no" for the opposite)
+class ConfigSearchIndex
+{
+public:
+    struct Entry
+    {
+        QString key;
+        QString value;
+        QString description;
+        int type = -1;
+        bool changed = false;
+    };
+
+    explicit ConfigSearchIndex(const QVector<Entry> &entries);
+
+    int count() const { return m_entries.count(); }
+    QVector<bool> match(const QString &query, const QFutureInterfaceBase *fi = nullptr) const;
+
+private:
+    enum Field { KeyField = 0x1, ValueField = 0x2, DescriptionField = 0x4, AllFields = 0x7 };
+
+    struct Posting
+    {
+        QString token;
+        int row;
+        int field;
+    };
+
+    void addTokens(const QString &lowerText, int row, Field field);
+    QVector<bool> matchPrefix(const QString &prefix, int fields) const;
+    QVector<bool> matchSubstring(const QString &needle, int fields) const;
+    QVector<bool> matchTerm(const QString &term) const;
+
+    QVector<Entry> m_entries; // key, value and description are stored lower case
+    QVector<Posting> m_postings; // sorted by token
+};
+
+// Proxy model for the ConfigModel that filters by a ConfigSearchIndex query in addition
+// to the regular QSortFilterProxyModel filtering. Large configurations are indexed and
+// matched in a worker thread.
+class ConfigModelFilter : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ConfigModelFilter(QObject *parent = nullptr);
+    ~ConfigModelFilter() override;
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    QString searchText() const;
+    void setSearchText(const QString &text);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    struct SearchResult
+    {
+        std::shared_ptr<const ConfigSearchIndex> index;
+        QVector<bool> accepted;
+    };
+
+    static void search(QFutureInterface<SearchResult> &fi,
+                       std::shared_ptr<const ConfigSearchIndex> index,
+                       const QVector<ConfigSearchIndex::Entry> &entries,
+                       const QString &query);
+
+    void sourceRowsChanged();
+    void sourceDataChanged();
+    void startSearch();
+    void searchFinished();
+    void applyResult(const SearchResult &result);
+    QVector<ConfigSearchIndex::Entry> snapshot() const;
+
+    QString m_searchText;
+    QVector<bool> m_accepted;
+    std::shared_ptr<const ConfigSearchIndex> m_index;
+    bool m_indexDirty = false; // the source data changed since m_index was built
+    QFutureWatcher<SearchResult> m_watcher;
+    bool m_restartSearch = false;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "configurescheduler.h"
+
+#include "cmakebuildconfiguration.h"
+
+#include <coreplugin/icore.h>
+#include <coreplugin/progressmanager/progressmanager.h>
+
+#include <utils/qtcassert.h>
+
+#include <QSettings>
+#include <QThread>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+const char MAX_JOBS_KEY[] = "CMakeSpecificSettings/MaxConcurrentConfigureJobs";
+
+} // namespace
+
+ConfigureScheduler *ConfigureScheduler::m_instance = nullptr;
+
+ConfigureScheduler::ConfigureScheduler(QObject *parent) : QObject(parent)
+{
+    QTC_ASSERT(!m_instance, return);
+    m_instance = this;
+
+    // cmake is mostly single threaded, but also runs compiler checks:
+    const int defaultJobs = qMax(1, QThread::idealThreadCount() / 2);
+    m_maxConcurrentJobs = qMax(1, Core::ICore::settings()->value(QLatin1String(MAX_JOBS_KEY),
+                                                                 defaultJobs).toInt());
+}
+
+ConfigureScheduler::~ConfigureScheduler()
+{
+    cancel();
+    m_instance = nullptr;
+}
+
+ConfigureScheduler *ConfigureScheduler::instance()
+{
+    return m_instance;
+}
+
+void ConfigureScheduler::configure(const QList<CMakeBuildConfiguration *> &buildConfigurations)
+{
+    foreach (CMakeBuildConfiguration *bc, buildConfigurations) {
+        if (!bc || m_queue.contains(bc) || m_running.contains(bc))
+            continue;
+        m_queue.append(bc);
+        ++m_total;
+    }
+
+    if (!m_future && (!m_queue.isEmpty() || !m_running.isEmpty())) {
+        m_future = new QFutureInterface<void>();
+        m_future->reportStarted();
+        Core::ProgressManager::addTask(m_future->future(), tr("Configuring all build configurations"),
+                                       "CMake.ConfigureAll");
+    }
+    updateProgress();
+    startJobs();
+}
+
+void ConfigureScheduler::cancel()
+{
+    m_queue.clear();
+    const QList<QPointer<CMakeBuildConfiguration>> running = m_running;
+    m_running.clear();
+    foreach (const QPointer<CMakeBuildConfiguration> &bc, running) {
+        if (!bc)
+            continue;
+        disconnect(bc.data(), nullptr, this, nullptr);
+        bc->cancelConfigure();
+    }
+    updateProgress();
+}
+
+bool ConfigureScheduler::isRunning() const
+{
+    return m_future != nullptr;
+}
+
+int ConfigureScheduler::maxConcurrentJobs() const
+{
+    return m_maxConcurrentJobs;
+}
+
+void ConfigureScheduler::startJobs()
+{
+    while (m_running.size() < m_maxConcurrentJobs && !m_queue.isEmpty()) {
+        QPointer<CMakeBuildConfiguration> bc = m_queue.takeFirst();
+        if (!bc) {
+            ++m_done;
+            continue;
+        }
+
+        // Each configuration reports its own cmake run to the progress manager:
+        if (!bc->configure()) {
+            ++m_done;
+            continue;
+        }
+        // Only connect now: configure() first stops a cmake run of the configuration that
+        // might have been going on, and that one must not count as this job:
+        m_running.append(bc);
+        connect(bc.data(), &CMakeBuildConfiguration::configureFinished, this,
+                [this, bc]() { jobFinished(bc.data()); });
+        connect(bc.data(), &QObject::destroyed, this,
+                [this, bc]() { jobFinished(bc.data()); });
+    }
+    updateProgress();
+}
+
+void ConfigureScheduler::jobFinished(CMakeBuildConfiguration *bc)
+{
+    if (bc)
+        disconnect(bc, nullptr, this, nullptr);
+    // A configuration that was destroyed is only a null entry by now:
+    const int index = m_running.indexOf(bc);
+    if (index < 0)
+        return;
+    m_running.removeAt(index);
+    ++m_done;
+    startJobs();
+}
+
+void ConfigureScheduler::updateProgress()
+{
+    if (!m_future)
+        return;
+
+    if (m_queue.isEmpty() && m_running.isEmpty()) {
+        if (m_done < m_total)
+            m_future->reportCanceled();
+        m_future->reportFinished();
+        delete m_future;
+        m_future = nullptr;
+        m_total = m_done = 0;
+        emit finished();
+        return;
+    }
+
+    m_future->setProgressRange(0, m_total);
+    m_future->setProgressValue(m_done);
+}
+
+} // namespace Internal
+} // namespace CMakeProjectManager
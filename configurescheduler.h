@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <QFutureInterface>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+class CMakeBuildConfiguration;
+
+// Runs cmake for many build configurations at once ("configure all"), with at most
+// maxConcurrentJobs() cmake processes at a time across all projects. The limit is read
+// from the "CMakeSpecificSettings/MaxConcurrentConfigureJobs" setting on startup and
+// defaults to half the number of cores.
+class ConfigureScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConfigureScheduler(QObject *parent = nullptr);
+    ~ConfigureScheduler() override;
+
+    static ConfigureScheduler *instance();
+
+    void configure(const QList<CMakeBuildConfiguration *> &buildConfigurations);
+    void cancel();
+    bool isRunning() const;
+
+    int maxConcurrentJobs() const;
+
+signals:
+    void finished();
+
+private:
+    void startJobs();
+    void jobFinished(CMakeBuildConfiguration *bc);
+    void updateProgress();
+
+    static ConfigureScheduler *m_instance;
+
+    QList<QPointer<CMakeBuildConfiguration>> m_queue;
+    QList<QPointer<CMakeBuildConfiguration>> m_running;
+    QFutureInterface<void> *m_future = nullptr;
+    int m_total = 0;
+    int m_done = 0;
+    int m_maxConcurrentJobs = 1;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
@@ -0,0 +1,306 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "generatedfilesindex.h"
+
+#include "cmakeproject.h"
+#include "cmakeprojectnodes.h"
+
+#include <utils/algorithm.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+#endif
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+namespace {
+
+bool isCodeFile(const Utils::FileName &fileName)
+{
+    static const QSet<QString> suffixes = {
+        "h", "hh", "hpp", "hxx", "c", "cc", "cpp", "cxx", "moc"
+    };
+    const QString name = fileName.fileName();
+    const int dot = name.lastIndexOf('.');
+    return dot >= 0 && suffixes.contains(name.mid(dot + 1));
+}
+
+Utils::FileName resolve(const QDir &directory, const QString &path)
+{
+    return Utils::FileName::fromString(QDir::cleanPath(directory.absoluteFilePath(path)));
+}
+
+// Splits a "build" statement of build.ninja into its paths, the unescaped ':' is
+// returned as separate token:
+QStringList ninjaTokens(const QString &line)
+{
+    QStringList tokens;
+    QString token;
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (c == '$' && i + 1 < line.size()) {
+            token.append(line.at(++i)); // "$ ", "$:" and "$$"
+        } else if (c == ' ' || c == ':') {
+            if (!token.isEmpty())
+                tokens.append(token);
+            token.clear();
+            if (c == ':')
+                tokens.append(QString(c));
+        } else {
+            token.append(c);
+        }
+    }
+    if (!token.isEmpty())
+        tokens.append(token);
+    return tokens;
+}
+
+QString unescapeMakePath(QString path)
+{
+    return path.replace("\\ ", " ").replace("$$", "$");
+}
+
+} // namespace
+
+GeneratedFilesIndex GeneratedFilesIndex::create(const Utils::FileName &buildDirectory,
+                                                const QList<CMakeBuildTarget> &targets,
+                                                const QList<FileNodeInfo> &files)
+{
+    GeneratedFilesIndex index;
+    for (const FileNodeInfo &info : files) {
+        if (!info.generated)
+            index.m_sources.insert(info.filePath());
+    }
+
+    // Exact rules first, the naming conventions only fill the gaps:
+    index.addNinjaRules(buildDirectory);
+    index.addMakefileRules(buildDirectory, targets);
+    index.addAutogenOutputs(targets);
+    index.addGeneratedUnits(files);
+
+    index.m_sources.clear();
+    return index;
+}
+
+Utils::FileNameList GeneratedFilesIndex::outputsFor(const Utils::FileName &source) const
+{
+    return m_outputs.value(source);
+}
+
+void GeneratedFilesIndex::addRule(const Utils::FileName &output, const Utils::FileName &input)
+{
+    if (!m_sources.contains(input) || !isCodeFile(output))
+        return;
+    Utils::FileNameList &outputs = m_outputs[input];
+    if (!outputs.contains(output))
+        outputs.append(output);
+}
+
+void GeneratedFilesIndex::addNinjaRules(const Utils::FileName &buildDirectory)
+{
+    QFile file(buildDirectory.toString() + "/build.ninja");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    const QDir directory(buildDirectory.toString());
+    QString statement;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine());
+        line.chop(line.endsWith('\n') ? 1 : 0);
+
+        // Statements continue on the next line after a trailing '$':
+        if (line.endsWith('$') && !line.endsWith("$$")) {
+            line.chop(1);
+            statement += line;
+            continue;
+        }
+        statement += line;
+        line.clear();
+
+        // build <outputs>: CUSTOM_COMMAND <inputs> | <implicit inputs> || <order only>
+        if (statement.startsWith("build ")) {
+            const QStringList tokens = ninjaTokens(statement.mid(6));
+            const int colon = tokens.indexOf(":");
+            if (colon > 0 && colon + 1 < tokens.size() && tokens.at(colon + 1) == "CUSTOM_COMMAND") {
+                for (int i = colon + 2; i < tokens.size() && tokens.at(i) != "||"; ++i) {
+                    if (tokens.at(i) == "|")
+                        continue;
+                    const Utils::FileName input = resolve(directory, tokens.at(i));
+                    for (int o = 0; o < colon; ++o)
+                        addRule(resolve(directory, tokens.at(o)), input);
+                }
+            }
+        }
+        statement.clear();
+    }
+}
+
+void GeneratedFilesIndex::addMakefileRules(const Utils::FileName &buildDirectory,
+                                           const QList<CMakeBuildTarget> &targets)
+{
+    // Rules in build.make are relative to the top level build directory:
+    const QDir directory(buildDirectory.toString());
+    QSet<QString> seen;
+    for (const CMakeBuildTarget &target : targets) {
+        // Same lookup as for flags.make, see BuildDirManager::extractFlagsFromMake():
+        const QString makeCommand = target.makeCommand.toString();
+        const int startIndex = makeCommand.indexOf('\"');
+        const int endIndex = makeCommand.indexOf('\"', startIndex + 1);
+        if (startIndex == -1 || endIndex == -1)
+            continue;
+        QString makefile = makeCommand.mid(startIndex + 1, endIndex - startIndex - 1);
+        makefile.truncate(makefile.lastIndexOf('/'));
+        makefile.append("/CMakeFiles/" + target.title + ".dir/build.make");
+        makefile.remove('\\');
+        if (seen.contains(makefile))
+            continue;
+        seen.insert(makefile);
+
+        QFile file(makefile);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            continue;
+
+        // One "<output>: <input>" line per dependency, recipes are indented:
+        while (!file.atEnd()) {
+            const QString line = QString::fromUtf8(file.readLine());
+            if (line.isEmpty() || line.startsWith('#') || line.startsWith('\t'))
+                continue;
+            const int separator = line.indexOf(": ");
+            if (separator <= 0)
+                continue;
+            const QString input = line.mid(separator + 2).trimmed();
+            if (input.isEmpty())
+                continue;
+            addRule(resolve(directory, unescapeMakePath(line.left(separator))),
+                    resolve(directory, unescapeMakePath(input)));
+        }
+    }
+}
+
+void GeneratedFilesIndex::addAutogenOutputs(const QList<CMakeBuildTarget> &targets)
+{
+    // AUTOUIC writes ui_<name>.h into the <target>_autogen include directory of the target:
+    for (const CMakeBuildTarget &target : targets) {
+        const auto autogenInclude = std::find_if(target.includeFiles.begin(), target.includeFiles.end(),
+                                                 [](const Utils::FileName &path) {
+            return path.toString().contains("_autogen/include");
+        });
+        if (autogenInclude == target.includeFiles.end())
+            continue;
+
+        for (const Utils::FileName &file : target.files) {
+            if (!file.endsWith(".ui") || !m_sources.contains(file) || m_outputs.contains(file))
+                continue;
+            Utils::FileName output = *autogenInclude;
+            output.appendPath("ui_" + QFileInfo(file.toString()).completeBaseName() + ".h");
+            m_outputs[file].append(output);
+        }
+    }
+}
+
+void GeneratedFilesIndex::addGeneratedUnits(const QList<FileNodeInfo> &files)
+{
+    QSet<Utils::FileName> knownOutputs;
+    for (const Utils::FileNameList &outputs : qAsConst(m_outputs)) {
+        for (const Utils::FileName &output : outputs)
+            knownOutputs.insert(output);
+    }
+
+    QHash<QString, Utils::FileNameList> sourcesByBaseName;
+    for (const Utils::FileName &source : qAsConst(m_sources))
+        sourcesByBaseName[QFileInfo(source.toString()).completeBaseName()].append(source);
+
+    // Generated units listed by cmake, matched to their source by the Qt naming conventions:
+    struct Convention { const char *prefix; const char *inputSuffix; };
+    static const Convention conventions[] = {
+        { "ui_", ".ui" }, { "qrc_", ".qrc" }, { "moc_", ".h" }
+    };
+    for (const FileNodeInfo &info : files) {
+        if (!info.generated)
+            continue;
+        const Utils::FileName output = info.filePath();
+        if (knownOutputs.contains(output))
+            continue;
+        const QString baseName = QFileInfo(info.fileName).completeBaseName();
+        for (const Convention &convention : conventions) {
+            if (!baseName.startsWith(QLatin1String(convention.prefix)))
+                continue;
+            const Utils::FileNameList candidates = Utils::filtered(
+                        sourcesByBaseName.value(baseName.mid(int(qstrlen(convention.prefix)))),
+                        [&convention](const Utils::FileName &source) {
+                return source.endsWith(QLatin1String(convention.inputSuffix));
+            });
+            // Ambiguous names are left alone rather than guessed:
+            if (candidates.size() == 1)
+                addRule(output, candidates.first());
+            break;
+        }
+    }
+}
+
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testGeneratedFilesIndex()
+{
+    QTemporaryDir buildDir;
+    QVERIFY(buildDir.isValid());
+    QFile ninja(buildDir.path() + "/build.ninja");
+    QVERIFY(ninja.open(QIODevice::WriteOnly));
+    ninja.write("build ui_main$ window.h: CUSTOM_COMMAND ../src/main$ window.ui /usr/bin/uic || cmake_order\n"
+                "build machine.h machine.cpp: CUSTOM_COMMAND $\n"
+                "    ../src/machine.scxml\n"
+                "build CMakeFiles/app.dir/main.cpp.o: CXX_COMPILER__app ../src/main.cpp\n");
+    ninja.close();
+
+    const QString srcDir = QDir::cleanPath(QFileInfo(buildDir.path()).absoluteFilePath() + "/../src");
+    const QString outDir = QFileInfo(buildDir.path()).absoluteFilePath();
+    auto file = [](const QString &path, bool generated = false) {
+        return FileNodeInfo(Utils::FileName::fromString(path), ProjectExplorer::SourceType, generated);
+    };
+    const QList<FileNodeInfo> files = {
+        file(srcDir + "/main window.ui"),
+        file(srcDir + "/machine.scxml"),
+        file(srcDir + "/main.cpp"),
+        file(srcDir + "/dialog.ui"),
+        file(outDir + "/sub/ui_dialog.h", true)
+    };
+
+    const GeneratedFilesIndex index
+            = GeneratedFilesIndex::create(Utils::FileName::fromString(outDir), {}, files);
+    QCOMPARE(index.outputsFor(Utils::FileName::fromString(srcDir + "/main window.ui")),
+             Utils::FileNameList({ Utils::FileName::fromString(outDir + "/ui_main window.h") }));
+    QCOMPARE(index.outputsFor(Utils::FileName::fromString(srcDir + "/machine.scxml")),
+             Utils::FileNameList({ Utils::FileName::fromString(outDir + "/machine.h"),
+                                   Utils::FileName::fromString(outDir + "/machine.cpp") }));
+    QCOMPARE(index.outputsFor(Utils::FileName::fromString(srcDir + "/dialog.ui")),
+             Utils::FileNameList({ Utils::FileName::fromString(outDir + "/sub/ui_dialog.h") }));
+    QVERIFY(!index.contains(Utils::FileName::fromString(srcDir + "/main.cpp")));
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
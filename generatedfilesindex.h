@@ -0,0 +1,60 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QHash>
+#include <QSet>
+
+namespace CMakeProjectManager {
+
+class CMakeBuildTarget;
+
+namespace Internal {
+
+struct FileNodeInfo;
+
+// Maps project sources to the files the build generates from them (uic, moc, rcc, scxml
+// and other custom commands), as far as cmake's own output tells.
+class GeneratedFilesIndex
+{
+public:
+    static GeneratedFilesIndex create(const Utils::FileName &buildDirectory,
+                                      const QList<CMakeBuildTarget> &targets,
+                                      const QList<FileNodeInfo> &files);
+
+    bool isEmpty() const { return m_outputs.isEmpty(); }
+    bool contains(const Utils::FileName &source) const { return m_outputs.contains(source); }
+    Utils::FileNameList outputsFor(const Utils::FileName &source) const;
+    void clear() { m_outputs.clear(); }
+
+private:
+    void addRule(const Utils::FileName &output, const Utils::FileName &input);
+    void addNinjaRules(const Utils::FileName &buildDirectory);
+    void addMakefileRules(const Utils::FileName &buildDirectory,
+                          const QList<CMakeBuildTarget> &targets);
+    void addAutogenOutputs(const QList<CMakeBuildTarget> &targets);
+    void addGeneratedUnits(const QList<FileNodeInfo> &files);
+
+    QSet<Utils::FileName> m_sources;
+    QHash<Utils::FileName, Utils::FileNameList> m_outputs;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
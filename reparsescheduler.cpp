@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#include "reparsescheduler.h"
+
+#include <utils/qtcassert.h>
+
+#ifdef WITH_TESTS
+#include "cmakeprojectplugin.h"
+
+#include <QTest>
+#endif
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+ReparseScheduler::ReparseScheduler(QObject *parent) : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ReparseScheduler::handleTimeout);
+}
+
+void ReparseScheduler::schedule(RunKind kind, int quietPeriod)
+{
+    if (m_pending) {
+        ++m_counters.triggersCoalesced;
+        m_pendingKind = qMax(m_pendingKind, kind);
+        // The shortest quiet period asked for since the last run wins:
+        m_quietPeriod = qMin(m_quietPeriod, quietPeriod);
+    } else {
+        m_pending = true;
+        m_pendingKind = kind;
+        m_quietPeriod = quietPeriod;
+    }
+
+    if (!m_followUp)
+        m_timer.start(m_quietPeriod);
+}
+
+bool ReparseScheduler::isPending() const
+{
+    return m_pending;
+}
+
+void ReparseScheduler::runStarted()
+{
+    QTC_CHECK(!m_running);
+    m_running = true;
+    m_runTimer.start();
+    ++m_counters.runsStarted;
+}
+
+void ReparseScheduler::runFinished(bool cancelled)
+{
+    if (!m_running)
+        return;
+    m_running = false;
+    if (cancelled)
+        ++m_counters.runsCancelled;
+
+    if (m_followUp) {
+        m_followUp = false;
+        m_timer.start(0);
+    }
+}
+
+ReparseScheduler::Counters ReparseScheduler::counters() const
+{
+    return m_counters;
+}
+
+void ReparseScheduler::handleTimeout()
+{
+    QTC_ASSERT(m_pending, return);
+
+    if (m_running) {
+        const bool cancel = m_pendingKind == Configure && m_runTimer.elapsed() < CANCEL_WINDOW;
+        if (!cancel) {
+            // Wait for the current run and start one more afterwards:
+            m_followUp = true;
+            return;
+        }
+    }
+
+    const RunKind kind = m_pendingKind;
+    m_pending = false;
+    m_pendingKind = Parse;
+    emit runRequested(kind);
+}
+
+#ifdef WITH_TESTS
+
+void CMakeProjectPlugin::testReparseScheduler()
+{
+    ReparseScheduler scheduler;
+    QList<ReparseScheduler::RunKind> runs;
+    connect(&scheduler, &ReparseScheduler::runRequested,
+            [&runs](ReparseScheduler::RunKind kind) { runs.append(kind); });
+
+    // Quick saves and a configuration change merge into one configure run:
+    scheduler.schedule(ReparseScheduler::Parse, 100);
+    scheduler.schedule(ReparseScheduler::Parse, 100);
+    scheduler.schedule(ReparseScheduler::Configure, 0);
+    QVERIFY(scheduler.isPending());
+    QTRY_COMPARE(runs.count(), 1);
+    QCOMPARE(runs.at(0), ReparseScheduler::Configure);
+    QCOMPARE(scheduler.counters().triggersCoalesced, 2);
+
+    // A trigger during a run is queued behind it:
+    scheduler.runStarted();
+    scheduler.schedule(ReparseScheduler::Parse, 0);
+    QTest::qWait(50);
+    QCOMPARE(runs.count(), 1);
+    scheduler.runFinished();
+    QTRY_COMPARE(runs.count(), 2);
+    QCOMPARE(runs.at(1), ReparseScheduler::Parse);
+    QVERIFY(!scheduler.isPending());
+    QCOMPARE(scheduler.counters().runsStarted, 1);
+    QCOMPARE(scheduler.counters().runsCancelled, 0);
+
+    // Every trigger extends the quiet period:
+    scheduler.schedule(ReparseScheduler::Parse, 300);
+    QTest::qWait(200);
+    scheduler.schedule(ReparseScheduler::Parse, 300);
+    QTest::qWait(200);
+    QCOMPARE(runs.count(), 2);
+    QTRY_COMPARE(runs.count(), 3);
+    QCOMPARE(runs.at(2), ReparseScheduler::Parse);
+
+    // A configure request early in a run is passed on right away, so the run gets cancelled:
+    scheduler.runStarted();
+    scheduler.schedule(ReparseScheduler::Configure, 0);
+    QTRY_COMPARE(runs.count(), 4);
+    QCOMPARE(runs.at(3), ReparseScheduler::Configure);
+    scheduler.runFinished(true);
+    QVERIFY(!scheduler.isPending());
+    QCOMPARE(scheduler.counters().runsStarted, 2);
+    QCOMPARE(scheduler.counters().runsCancelled, 1);
+}
+
+#endif
+
+} // namespace Internal
+} // namespace CMakeProjectManager
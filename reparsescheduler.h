@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 Alexander Drozdov.
+** Contact: adrozdoff@gmail.com
+**
+** This file is part of CMakeProjectManager2 plugin.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file.  Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+****************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+namespace CMakeProjectManager {
+namespace Internal {
+
+// Merges reparse triggers of one build directory into as few cmake runs as possible.
+//
+// Every trigger (re)starts a quiet period; the run is only requested once no further
+// trigger arrived for that long. A run that is already going is only cancelled for a
+// configure request within the first CANCEL_WINDOW ms, later on one follow-up run is
+// queued instead, so a run that is nearly done always completes.
+class ReparseScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum RunKind {
+        Parse,    // rerun cmake only if its input files changed
+        Configure // always rerun cmake with the intended configuration
+    };
+
+    struct Counters
+    {
+        int runsStarted = 0;
+        int runsCancelled = 0;
+        int triggersCoalesced = 0;
+    };
+
+    static const int CANCEL_WINDOW = 1000;
+
+    explicit ReparseScheduler(QObject *parent = nullptr);
+
+    void schedule(RunKind kind, int quietPeriod);
+    bool isPending() const;
+
+    // To be called by the owner when cmake actually starts or ends:
+    void runStarted();
+    void runFinished(bool cancelled = false);
+
+    Counters counters() const;
+
+signals:
+    // Before a Configure run is requested while cmake is running, the owner has to
+    // stop the running process.
+    void runRequested(CMakeProjectManager::Internal::ReparseScheduler::RunKind kind);
+
+private:
+    void handleTimeout();
+
+    QTimer m_timer;
+    QElapsedTimer m_runTimer;
+    RunKind m_pendingKind = Parse;
+    int m_quietPeriod = 0;
+    bool m_pending = false;
+    bool m_followUp = false;
+    bool m_running = false;
+    Counters m_counters;
+};
+
+} // namespace Internal
+} // namespace CMakeProjectManager
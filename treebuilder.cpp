@@ -16,6 +16,7 @@
 **
 ****************************************************************************/
 #include "treebuilder.h"
+#include "cmaketrace.h"
 
 #include <coreplugin/fileiconprovider.h>
 #include <coreplugin/icore.h>
@@ -91,6 +92,8 @@ void TreeBuilder::startScanning(const Utils::FileName &baseDir)
 
 void TreeBuilder::run(QFutureInterface<void> &fi)
 {
+    TraceSpan span(traceScan(), "Scan source tree");
+
     m_futureCount = 0;
     fi.setProgressRange(0, 10);
 
@@ -160,6 +163,7 @@ void TreeBuilder::buildTree(const Utils::FileName &baseDir,
     if (symlinkDepth == 0)
         return;
 
+    const QString directory = FileNodeInfo::sharedDirectory(baseDir.toString());
     const QFileInfoList fileInfoList = QDir(baseDir.toString()).entryInfoList(QDir::Files |
                                                                               QDir::Dirs |
                                                                               QDir::NoDotAndDotDot |
@@ -178,7 +182,7 @@ void TreeBuilder::buildTree(const Utils::FileName &baseDir,
             m_pathsForFuture.append(fn);
             buildTree(fn, fi, symlinkDepth - fileInfo.isSymLink());
         } else if (isValidFile(fileInfo)) {
-            auto nodeInfo = fileNodeInfo(fn);
+            auto nodeInfo = fileNodeInfo(fn, directory);
             m_filesForFuture.append(std::move(nodeInfo));
         }
     }
@@ -209,11 +213,11 @@ QList<FileNode *> TreeBuilder::fileNodes(const Utils::FileNameList &files)
 {
     return Utils::transform(files, [](const Utils::FileName &fileName) {
         auto nodeInfo = fileNodeInfo(fileName);
-        return new ProjectExplorer::FileNode(nodeInfo.filePath, nodeInfo.fileType, nodeInfo.generated);
+        return new ProjectExplorer::FileNode(fileName, nodeInfo.fileType, nodeInfo.generated);
     });
 }
 
-FileNodeInfo TreeBuilder::fileNodeInfo(const Utils::FileName &fileName)
+FileNodeInfo TreeBuilder::fileNodeInfo(const Utils::FileName &fileName, const QString &sharedDirectory)
 {
     FileNodeInfo node;
     bool generated = false;
@@ -224,7 +228,7 @@ FileNodeInfo TreeBuilder::fileNodeInfo(const Utils::FileName &fileName)
         generated = true;
 
     if (fileName.endsWith(QLatin1String("CMakeLists.txt"))) {
-        node = FileNodeInfo(fileName, ProjectExplorer::ProjectFileType, false);
+        node = FileNodeInfo(fileName, ProjectExplorer::ProjectFileType, false, sharedDirectory);
     } else {
 #if 1
         ProjectExplorer::FileType fileType = getFileType(fileName.toString());
@@ -233,7 +237,7 @@ FileNodeInfo TreeBuilder::fileNodeInfo(const Utils::FileName &fileName)
         if (onlyFileName.endsWith(".qrc"))
             fileType = ResourceType;
 #endif
-        node = FileNodeInfo(fileName, fileType, generated);
+        node = FileNodeInfo(fileName, fileType, generated, sharedDirectory);
     }
 
     return node;
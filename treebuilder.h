@@ -42,7 +42,9 @@ public:
     void clear();
 
     static QList<ProjectExplorer::FileNode*> fileNodes(const Utils::FileNameList &files);
-    static FileNodeInfo fileNodeInfo(const Utils::FileName& fileName);
+    // sharedDirectory: FileNodeInfo::sharedDirectory() of the parent directory, if known
+    static FileNodeInfo fileNodeInfo(const Utils::FileName& fileName,
+                                     const QString &sharedDirectory = QString());
 
     void startScanning(const Utils::FileName &baseDir);
     void cancel();